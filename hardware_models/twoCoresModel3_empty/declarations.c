@@ -36,11 +36,16 @@ typedef uint8_t instruction_t;
 
 typedef instruction_t[100] program_t;
 
+// the registers hold 32 bit values, extract --slice-regs keeps only the
+// ones the program uses
+// @begin registers
 typedef struct {
   int[16] r;
-  int sr;
+  uint8_t sr;
 } registers_t;
+// @end registers
 
+// @begin cache
 /*
  * cache line info:
  *  bit 31 is valid bit
@@ -49,7 +54,15 @@ typedef struct {
 const int valid = 1 << 31;
 const int tagMask = (1 << 31) - 1;
 typedef int[16] cache_t;
+// @end cache
 
+// no data cache unless generated by extract --dcache
+// @begin dcache
+// @end dcache
+
+// the memory words hold 32 bit values, extract --segments keeps only the
+// words the program uses
+// @begin state
 typedef struct {
   int[30] a;
 } mem_t;
@@ -60,36 +73,39 @@ typedef struct {
 } core_t;
 
 typedef core_t[1] state_t;
+// @end state
+
+// no bus arbitration unless generated by arbiter.py
+// @begin arbiter
+// @end arbiter
 
 initially {
   // state of the system
+// @begin initState
   state_t st;
   mem_t[1] mem;
   // = 1 if a cache access is a hit
-  int[1] isHit = {0};
+  uint8_t[1] isHit = {0};
   // access count of an instruction
-  int[1] ac = {0};
+  uint8_t[1] ac = {0};
   //
   uint8_t[2] doFetch = {0, 0};
+// @end initState
   //
   uint8_t lockBus = 0;
   uint8_t accessCount = 0;
   //
   uint16_t prologAccessCount = 40;
+// @begin initArbiter
+// @end initArbiter
 
+// @begin initCores
   initCache(st[0].ICache);
   // initCache(st[1].ICache);
 
   // initialise registers arbitrarily
-  for (int i = 0; i < 16; i++) {
-    st[0].regs.r[i] = i;
-    //    st[1].regs.r[i] = 20 + i;
-  }
-  st[0].regs.sr = 0;
-  //  st[1].regs.sr = 0;
-  
-  st[0].regs.r[13] = dataStart + 100;
-  // st[1].regs.r[13] = dataStart + 560;
+  initRegs(st[0].regs);
+  // initRegs(st[1].regs);
 
   // Initialise memory arbitrarily
   for (int i = 0; i < 30; i++) {
@@ -97,15 +113,31 @@ initially {
   }
   
   initConsts(mem[0]);
+// @end initCores
 
 }
 
+// @begin initCache
 void initCache(cache_t &cache) {
   int i;
   for (i = 0; i < 16; i++) {
     cache[i] = 0; // not valid
   }
 }
+// @end initCache
+
+// @begin initDCache
+// @end initDCache
+
+// @begin initRegs
+void initRegs(registers_t &regs) {
+  for (int i = 0; i < 16; i++) {
+    regs.r[i] = i;
+  }
+  regs.sr = 0;
+  regs.r[13] = dataStart + 100;
+}
+// @end initRegs
 
 void updateSR(registers_t &regs, uint64_t val, uint32_t op1, uint32_t op2) {
   if (val == 0) {
@@ -135,12 +167,13 @@ void updateSR(registers_t &regs, uint64_t val, uint32_t op1, uint32_t op2) {
   regs.sr = status;
 }
 
-/* Does an access to a cache and return 0 if hit and 1 if miss */
+// @begin cacheAccess
+/* Does an access to a cache and return 1 if hit and 0 if miss */
 int cacheAccess(cache_t &cache, int addr) {
   int line = (addr >> 5) & 15;
   int tag = addr >> 9 & tagMask;
   int result;
-  if ((cache[line] & valid) != 0 && (cache[line] & tagMask == tag)) {
+  if ((cache[line] & valid) != 0 && ((cache[line] & tagMask) == tag)) {
     result = 1;
   } else {
     result = 0;
@@ -148,7 +181,12 @@ int cacheAccess(cache_t &cache, int addr) {
   }
   return result;
 }
+// @end cacheAccess
+
+// @begin dcacheAccess
+// @end dcacheAccess
 
+// @begin memAccess
 uint32_t memRead(mem_t &mem, uint32_t address) {
   return mem.a[(address - dataStart) / 4];
 }
@@ -188,5 +226,10 @@ void memWrite8(mem_t &mem, uint32_t address, uint8_t b) {
   data = (data & mask) | (word32 << offset);
   memWrite(mem, address, data);
 }
+// @end memAccess
+
+// no bus cycles of the accesses unless generated by extract --memory-map
+// @begin memCycles
+// @end memCycles
 
 void initConsts(mem_t &mem) {}
@@ -2,29 +2,46 @@
 # Modules
 #------------------------------------------------------------
 import argparse
+import json
 import os
 import sys
 import re
+import tempfile
 
 #------------------------------------------------------------
 # Constants
 #------------------------------------------------------------
 output_dir = "generated_files/"
 
+# format of the hardware net templates, in their name (see load_hardware_template)
+hardware_template_version = 1
+
 gcc_options = "-mcpu=cortex-m0plus -mthumb -mfloat-abi=soft -mfpu=fpv4-sp-d16 -nostartfiles -fno-builtin --specs=nosys.specs -nostdlib"
 #gcc_options = "-mcpu=cortex-m4 -mthumb -mfloat-abi=soft -mfpu=fpv4-sp-d16 -nostartfiles -fno-builtin --specs=nosys.specs -nostdlib"
 
 #------------------------------------------------------------
-# This line can be customized using other files
+# Hardware models (--model), in hardware_models/[name]/, with
+# the extract options they need
 #------------------------------------------------------------
-hardware_model_root = "hardware_models/twoCoresModel3_empty/"
-# TODO (ÉA, 2024/01/19): add an option somewhere! (earlier default: twoCoresModel3_empty.xml)
+hardware_models_dir = "hardware_models/"
+hardware_models = {
+    # two cores sharing the bus, each with an instruction cache
+    "twoCoresModel3_empty": "",
+    # same hardware with a prefetch buffer of one word
+    "twoCoresModel3_prefetch": " --prefetch",
+}
+default_hardware_model = "twoCoresModel3_empty"
 
-#------------------------------------------------------------
-# Customized constants depending on hardware_model_root
-#------------------------------------------------------------
-declarations_input_file_name    = hardware_model_root + "declarations.c"
-core_model_name                 = hardware_model_root + "hardware.xml"
+
+def hardware_model_files(model):
+    """
+    Files of a hardware model
+    :param model: name of the hardware model
+    :return: declaration file and net of the hardware model
+    """
+    hardware_model_root = os.path.join(hardware_models_dir, model)
+    return (os.path.join(hardware_model_root, "declarations.c"),
+            os.path.join(hardware_model_root, "hardware.xml"))
 
 
 def extract_address(line):
@@ -39,51 +56,6 @@ def extract_address(line):
     return address
 
 
-def update_xml(xml_file, files_to_input=[], slave_models_to_input=[]):
-    """
-    Update an xml file for Roméo with files
-    :param xml_file: path to the XML file
-    :param files_to_input: Files to input in the project
-    :param slave_models_to_input: Files of models to input in the project as slaves
-    :return: None
-    """
-    # Get content
-    f = open(xml_file, "r")
-    content = f.readlines()
-    f.close()
-
-    # Update content
-    content_to_write = []
-    for line in content:
-        # token in first place
-        if '<place id="1"' in line:
-            content_to_write.append(line.replace('initialMarking="0"', 'initialMarking="1"'))
-        # update nb token
-        elif "<nbTokenColor>" in line:
-            content_to_write.append("<nbTokenColor>1</nbTokenColor>\n")
-        # insert files
-        elif "<project" in line:
-            content_to_write.append(
-                '<project nbinput="{}" openinput="{}" nbinclude="{}" >\n'.format(len(slave_models_to_input), 0,
-                                                                                 len(files_to_input)))
-            i = 1
-            for model in slave_models_to_input:
-                content_to_write.append(
-                    '\t<input id="{}"  file="{}"  status="closed"/>\n'.format(i, os.path.basename(model)))
-                i += 1
-            i = 1
-            for file in files_to_input:
-                content_to_write.append('\t<include id="{}" file="{}"/>\n'.format(i, os.path.basename(file)))
-                i += 1
-        else:
-            content_to_write.append(line)
-
-    # Write file
-    f = open(xml_file, "w")
-    f.writelines(content_to_write)
-    f.close()
-
-
 def get_last_instruction(compiled_file, file_name):
     """
     From a compiled file, try to return the last instruction
@@ -126,13 +98,132 @@ def get_last_instruction(compiled_file, file_name):
     return last_address
 
 
-def run(file_name, file_path=""):
+def compile_program(input_file, compiled_file):
+    """
+    Compile a C file and extract its instructions for extract
+    :param input_file: C file
+    :param compiled_file: compiled file, the instructions are written to [compiled_file].bin
+    :return: None
+    """
+    os.system(
+        ("arm-none-eabi-gcc -O0 {} -o {} " + gcc_options).format(
+            input_file, compiled_file
+        ))
+    os.system("arm-none-eabi-objdump -d {} | awk -f src/extract.awk > {}".format(compiled_file, compiled_file + ".bin"))
+
+
+def data_segments(compiled_file):
+    """
+    From a compiled file, get the segments of its .data and .bss sections
+    :param compiled_file: Path to an ARM compiled file
+    :return: List of segments [name]=[address]:[size] (sections not empty)
+    """
+    segments = []
+    r = re.compile(r"^\s*\d+\s+\.(data|bss)\s+([0-9a-f]+)\s+([0-9a-f]+)")
+    headers = os.popen("arm-none-eabi-objdump -h {}".format(compiled_file)).read()
+    for line in headers.splitlines():
+        m = r.match(line)
+        if m and int(m.groups()[1], 16) > 0:
+            segments.append("{}=0x{}:0x{}".format(m.groups()[0], m.groups()[2], m.groups()[1]))
+    return segments
+
+
+def parse_hardware_template(content):
+    """
+    Split a hardware net around its program dependent parts: the number of
+    token colors and the interval of the bus access T3
+    :param content: hardware net
+    :return: list of parts: ["text", text], ["colors"], ["access", groups of the T3 interval]
+    """
+    r = re.compile(r'<nbTokenColor>\d+</nbTokenColor>|'
+                   r'(identifier="T3"[^>]*?\beft=")(\d+)(" lft=")(\d+)(" eft_param=")(\d+)(" lft_param=")(\d+)')
+    template = []
+    last = 0
+    for m in r.finditer(content):
+        template.append(["text", content[last:m.start()]])
+        if m.group(1) is None:
+            template.append(["colors"])
+        else:
+            template.append(["access", list(m.groups())])
+        last = m.end()
+    template.append(["text", content[last:]])
+    return template
+
+
+def load_hardware_template(model_file):
+    """
+    Template of a hardware net, kept in the output directory as
+    [model]_[net].v[version].template and parsed again only when the net is
+    newer. Written to a temporary file renamed in place, so that a concurrent
+    run never reads it half written
+    :param model_file: hardware net
+    :return: Template (see parse_hardware_template)
+    """
+    path = os.path.abspath(model_file)
+    template_path = os.path.join(output_dir, "{}_{}.v{}.template".format(
+        os.path.basename(os.path.dirname(path)), os.path.basename(path), hardware_template_version))
+    if os.path.isfile(template_path) and os.path.getmtime(template_path) >= os.path.getmtime(model_file):
+        with open(template_path, "r") as f:
+            return json.load(f)
+    with open(model_file, "r") as f:
+        template = parse_hardware_template(f.read())
+    fd, temp_path = tempfile.mkstemp(dir=output_dir, suffix=".tmp")
+    with os.fdopen(fd, "w") as f:
+        json.dump(template, f)
+    os.replace(temp_path, template_path)
+    return template
+
+
+def write_hardware_model(model_file, output_file, cores, cycle_access=False):
+    """
+    Copy the hardware model with one token color per core
+    :param model_file: hardware model
+    :param output_file: copy of the hardware model
+    :param cores: number of cores
+    :param cycle_access: a bus access (T3) takes one cycle, the access count being in bus cycles
+    :return: None
+    """
+    content = []
+    for part in load_hardware_template(model_file):
+        if part[0] == "text":
+            content.append(part[1])
+        elif part[0] == "colors":
+            content.append("<nbTokenColor>{}</nbTokenColor>".format(cores))
+        else:
+            g = part[1]
+            if cycle_access:
+                g = [g[0], "1", g[2], "1", g[4], "1", g[6], "1"]
+            content.append("".join(g))
+    f = open(output_file, "w")
+    f.write("".join(content))
+    f.close()
+
+
+def run(file_name, file_path="", full_registers=False, secrets=[], compact=False, por=False, cache=None,
+        cores=1, core_files=[], shared=None, dcache=None, model=default_hardware_model, arbiter=None, slot=20,
+        segments=False, memory_map=None):
     """
     From a file_name, generate the PN
     :param file_name:
+    :param full_registers: keep the 16 registers in the model state instead of the ones used by the program
+    :param secrets: secret inputs (registers or memory ranges), the data that does not depend on them is abstracted
+    :param compact: write the PN without layout data (it cannot be edited in the GUI)
+    :param por: give the instruction transitions priority over the hardware (partial order reduction)
+    :param cache: cache of the model, <sets>,<ways>,<line size>[,lru|fifo|plru][,unified] (default: the one of the hardware model)
+    :param cores: number of cores running the program
+    :param core_files: programs of the cores that do not run the program, [core]=[path to C file]
+    :param shared: memory shared by the cores, [address]:[size]
+    :param dcache: data cache of the cores, <sets>,<ways>,<line size>[,lru|fifo|plru] (default: none)
+    :param model: hardware model, a key of hardware_models
+    :param arbiter: bus arbitration policy, priority, rr, fifo or tdma (default: none, any waiting core takes the bus)
+    :param slot: with the tdma arbitration, length of a slot in cycles
+    :param segments: memory of a compact array per segment used by the program (.rodata, stack, .data, .bss)
+    :param memory_map: memory map file, the bus accesses take the wait states of their region (default: none)
     :return: PN file
     """
 
+    declarations_input, core_model = hardware_model_files(model)
+
     # make sure the output directory exists
     if not os.path.exists(output_dir):
         os.mkdir(output_dir)
@@ -141,45 +232,82 @@ def run(file_name, file_path=""):
     compiled_file = os.path.join(output_dir, file_name)
     bin_file = compiled_file + ".bin"
     rowdata_file = compiled_file + ".rowdata"
-    output_xml_file = rowdata_file = compiled_file + ".xml"
+    output_xml_file = compiled_file + ".xml"
     instructions_file = os.path.join(output_dir, "instructions_{}".format(file_name) + ".c")
+    sections_file = compiled_file + ".sections"
+    arbiter_sections_file = compiled_file + ".arbiter"
     declarations_output_file = os.path.join(output_dir, "{}_{}".format(
-        os.path.basename(os.path.splitext(declarations_input_file_name)[0]), file_name) + ".c")
-
-    # compile
-    os.system(
-        ("arm-none-eabi-gcc -O0 {} -o {} " + gcc_options).format(
-            input_file, compiled_file
-        ))
+        os.path.basename(os.path.splitext(declarations_input)[0]), file_name) + ".c")
 
-    # extract
-    os.system("arm-none-eabi-objdump -d {} | awk -f src/extract.awk > {}".format(compiled_file, bin_file))
+    # compile and extract
+    compile_program(input_file, compiled_file)
 
     # Extract last instruction
     last_instruction = get_last_instruction(compiled_file, file_name)
 
     # extract rowdata
     os.system("arm-none-eabi-objdump -s -j .rodata {} > {}".format(compiled_file, rowdata_file))
-    os.system(
-        "python3 src/extract_variables.py {} --output {} -u -ufile {}".format(rowdata_file, declarations_output_file,
-                                                                              declarations_input_file_name))
 
-    # Extract instructions
-    extract_command = "cat {} | src/extract {} > {}".format(bin_file, last_instruction, instructions_file)
+    # Extract instructions (and the program dependent declaration sections)
+    # and write the Roméo project
+    extract_options = "" if full_registers else " --slice-regs"
+    # cycles of the instructions on the core the program is compiled for
+    mcpu = re.search(r"-mcpu=(\S+)", gcc_options)
+    if mcpu:
+        extract_options += " --mcpu {}".format(mcpu.groups()[0])
+    for secret in secrets:
+        extract_options += " --secret {}".format(secret)
+    if compact:
+        extract_options += " --compact"
+    if por:
+        extract_options += " --por"
+    if cache is not None:
+        extract_options += " --cache {}".format(cache)
+    if dcache is not None:
+        extract_options += " --dcache {}".format(dcache)
+    if segments:
+        extract_options += " --segments"
+        for segment in data_segments(compiled_file):
+            extract_options += " --segment {}".format(segment)
+    if cache is not None or dcache is not None or segments or memory_map is not None or \
+            shared is not None:
+        extract_options += " --rodata {}".format(rowdata_file)
+    extract_options += hardware_models[model]
+    hardware_model = core_model
+    if memory_map is not None:
+        extract_options += " --memory-map {}".format(memory_map)
+    if cores > 1 or arbiter is not None or memory_map is not None:
+        hardware_model = os.path.join(output_dir, "{}_{}.xml".format(
+            os.path.basename(os.path.splitext(core_model)[0]), file_name))
+        write_hardware_model(core_model, hardware_model, cores, memory_map is not None)
+    if cores > 1:
+        extract_options += " --cores {}".format(cores)
+    splice_options = " -splice {}".format(sections_file)
+    if arbiter is not None:
+        os.system("python3 src/arbiter.py {} --cores {} --slot {} --input {} --output {} --sections {}".format(
+            arbiter, cores, slot, hardware_model, hardware_model, arbiter_sections_file))
+        splice_options += " -splice {}".format(arbiter_sections_file)
+    for core_file in core_files:
+        core, core_path = core_file.split("=", 1)
+        core_name = os.path.basename(os.path.splitext(core_path)[0])
+        core_compiled_file = os.path.join(output_dir, core_name)
+        compile_program(core_path, core_compiled_file)
+        extract_options += " --core-program {}={}.bin,{}".format(
+            core, core_compiled_file, get_last_instruction(core_compiled_file, core_name))
+    if shared is not None:
+        extract_options += " --shared {}".format(shared)
+    extract_options += " --output {} --input {}".format(output_xml_file, hardware_model)
+    for file in [declarations_output_file, instructions_file]:
+        extract_options += " --include {}".format(file)
+    extract_command = "cat {} | src/extract{} --decl {} {} > {}".format(
+        bin_file, extract_options, sections_file, last_instruction, instructions_file)
     print("Command for extracting instructions:")
     print("  " + extract_command)
     os.system(extract_command)
 
-    # Rename output
-    rename_command = "mv {} {}".format("program.xml", output_xml_file)
-    print("Command for renaming:")
-    print("  " + rename_command)
-    os.system(rename_command)
-
-    # update output
-    slave_models_to_input = [core_model_name]
-    files_to_input = [declarations_output_file, instructions_file]
-    update_xml(output_xml_file, files_to_input, slave_models_to_input)
+    os.system(
+        "python3 src/extract_variables.py {} --output {} -u -ufile {}{}".format(
+            rowdata_file, declarations_output_file, declarations_input, splice_options))
 
     print("Property to get the execution times: {}".format("EF[p,p](INST{}[0]>0)".format(last_instruction)))
 
@@ -188,10 +316,64 @@ if __name__ == "__main__":
     parser = argparse.ArgumentParser(
         prog='main',
         description='From a c programm, generate a Petri net')
-    parser.add_argument('file',
+    parser.add_argument('file', nargs='?',
                         help='path to the c file')
+    parser.add_argument('--full-registers',
+                        default=False, action='store_true',
+                        help='keep the 16 registers in the model state (default: only the registers used by the program)')
+    parser.add_argument('--secret',
+                        action='append', default=[],
+                        help='secret input: register (r0-r12, sp, lr) or memory range [address]:[size] (can be repeated)')
+    parser.add_argument('--compact',
+                        default=False, action='store_true',
+                        help='write the PN without layout data, for batch verification (the PN cannot be edited in the GUI)')
+    parser.add_argument('--por',
+                        default=False, action='store_true',
+                        help='give the instruction transitions priority over the hardware when the hardware model allows it (partial order reduction)')
+    parser.add_argument('--cache',
+                        default=None,
+                        help='cache of the model: <sets>,<ways>,<line size>[,lru|fifo|plru][,unified] (default: 16,1,32, instructions only)')
+    parser.add_argument('--cores',
+                        default=1, type=int,
+                        help='number of cores of the model (default: 1)')
+    parser.add_argument('--core',
+                        action='append', default=[],
+                        help='program of a core instead of the c file: [core]=[path to c file] (can be repeated)')
+    parser.add_argument('--shared',
+                        default=None,
+                        help='memory shared by the cores: [address]:[size] (default: none, each core has its own memory)')
+    parser.add_argument('--dcache',
+                        default=None,
+                        help='data cache of the cores: <sets>,<ways>,<line size>[,lru|fifo|plru] (default: none, every data access is a bus access)')
+    parser.add_argument('--segments',
+                        default=False, action='store_true',
+                        help='memory of a compact array per segment used by the program: .rodata, stack, .data and .bss (default: 30 words from the .rodata)')
+    parser.add_argument('--memory-map',
+                        default=None,
+                        help='memory map file: lines "<name> <address> <size> <wait states> [burst] [stack]" and "access <cycles>" (default: every bus access takes the T3 of the hardware model)')
+    parser.add_argument('--model',
+                        default=default_hardware_model, choices=sorted(hardware_models),
+                        help='hardware model, in ' + hardware_models_dir + ' (default: ' + default_hardware_model + ')')
+    parser.add_argument('--list-models',
+                        default=False, action='store_true',
+                        help='list the hardware models and exit')
+    parser.add_argument('--arbiter',
+                        default=None, choices=["priority", "rr", "fifo", "tdma"],
+                        help='bus arbitration: priority (the lowest core first), rr (round-robin), fifo (the oldest request first) or tdma (the core of the current slot) (default: any waiting core takes the bus)')
+    parser.add_argument('--slot',
+                        default=20, type=int,
+                        help='with --arbiter tdma, length of a slot in cycles (default: 20)')
     args = parser.parse_args()
 
+    if args.list_models:
+        for model in sorted(hardware_models):
+            print("{}{}".format(model, " (default)" if model == default_hardware_model else ""))
+        sys.exit(0)
+    if args.file is None:
+        parser.error("the c file is required")
+
     file_name = os.path.basename(os.path.splitext(args.file)[0])
     file_path = os.path.dirname(args.file)
-    run(file_name, file_path)
+    run(file_name, file_path, args.full_registers, args.secret, args.compact, args.por, args.cache,
+        args.cores, args.core, args.shared, args.dcache, args.model, args.arbiter, args.slot,
+        args.segments, args.memory_map)
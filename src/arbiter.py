@@ -0,0 +1,297 @@
+import argparse
+import re
+
+policies = ["priority", "rr", "fifo", "tdma"]
+
+# the requests of an instant are registered before the bus is granted
+request_priority = 2
+
+
+def place(id, name, marking, x, y):
+    return ("  <place id=\"{}\" identifier=\"{}\" label=\"{}\" initialMarking=\"{}\" eft=\"0\" lft=\"inf\"> \n"
+            "      <graphics color=\"0\"> \n"
+            "         <position x=\"{}\" y=\"{}\"/> \n"
+            "         <deltaLabel deltax=\"10\" deltay=\"10\"/> \n"
+            "      </graphics> \n"
+            "      <scheduling gamma=\"0\" omega=\"0\"/> \n"
+            "  </place> \n\n").format(id, name, name, marking, x, y)
+
+
+def transition(id, name, delay, priority, guard, update, x, y):
+    return ("  <transition id=\"{}\" identifier=\"{}\" label=\"{}\"  eft=\"{}\" lft=\"{}\" eft_param=\"{}\" lft_param=\"{}\" speed=\"1\" priority=\"{}\" cost=\"0\" unctrl=\"0\" obs=\"1\"  guard=\"{}\"> \n"
+            "     <graphics color=\"0\"> \n"
+            "        <position x=\"{}\" y=\"{}\"/> \n"
+            "        <deltaLabel deltax=\"25\" deltay=\"0\"/> \n"
+            "        <deltaGuard deltax=\"20\" deltay=\"-20\"/> \n"
+            "        <deltaUpdate deltax=\"20\" deltay=\"10\"/> \n"
+            "        <deltaSpeed deltax=\"-20\" deltay=\"5\"/> \n"
+            "        <deltaCost deltax=\"-20\" deltay=\"5\"/> \n"
+            "     </graphics> \n"
+            "     <update><![CDATA[{}]]></update> \n"
+            "  </transition> \n\n").format(id, name, name, delay, delay, delay, delay, priority, guard, x, y, update)
+
+
+def arc(place, transition, to_place):
+    if to_place:
+        return ("  <arc place=\"{}\" transition=\"{}\" type=\"TransitionPlace\" weight=\"1\" tokenColor=\"-1\"> \n"
+                "     <nail xnail=\"0\" ynail=\"0\"/> \n"
+                "     <graphics  color=\"0\"> \n"
+                "     </graphics> \n"
+                "  </arc> \n\n").format(place, transition)
+    return ("  <arc place=\"{}\" transition=\"{}\" type=\"PlaceTransition\" weight=\"1\" tokenColor=\"-1\"  inhibitingCondition=\"\"> \n"
+            "    <nail xnail=\"0\" ynail=\"0\"/> \n"
+            "    <graphics  color=\"0\"> \n"
+            "     </graphics> \n"
+            "  </arc> \n \n\n").format(place, transition)
+
+
+def find_id(content, kind, name):
+    """
+    Id of a place or a transition of the hardware model
+    :param content: hardware model
+    :param kind: place or transition
+    :param name: identifier of the place or transition
+    :return: id
+    """
+    m = re.search(r'<{} id="(\d+)" identifier="{}"'.format(kind, name), content)
+    if m is None:
+        raise Exception("{} {} not found in the hardware model".format(kind.capitalize(), name))
+    return int(m.group(1))
+
+
+def free_ids(content, kind, count):
+    """
+    Ids of new places or transitions, after the ones of the hardware model
+    :return: list of count ids
+    """
+    last = max(int(i) for i in re.findall(r'<{} id="(\d+)"'.format(kind), content))
+    return list(range(last + 1, last + 1 + count))
+
+
+def set_transition(content, name, guard=None, update=None):
+    """
+    Change the guard and/or the update of a transition of the hardware model
+    :param content: hardware model
+    :param name: identifier of the transition
+    :return: hardware model
+    """
+    r = re.compile(r'(<transition [^>]*identifier="' + name + r'"[^>]*guard=")([^"]*)(".*?<update><!\[CDATA\[)(.*?)(\]\]>)',
+                   re.S)
+    m = r.search(content)
+    if m is None:
+        raise Exception("Transition {} not found in the hardware model".format(name))
+    new_guard = m.group(2) if guard is None else guard(m.group(2))
+    new_update = m.group(4) if update is None else update(m.group(4))
+    return content[:m.start()] + m.group(1) + new_guard + m.group(3) + new_update + m.group(5) + content[m.end():]
+
+
+def move_arc(content, place, transition, new_place):
+    """
+    Move the input arc of a transition from a place to another
+    """
+    old = '<arc place="{}" transition="{}" type="PlaceTransition"'.format(place, transition)
+    if old not in content:
+        raise Exception("No arc from place {} to transition {} in the hardware model".format(place, transition))
+    return content.replace(old, '<arc place="{}" transition="{}" type="PlaceTransition"'.format(new_place, transition))
+
+
+def remove_arc(content, place, transition):
+    """
+    Remove the input arc of a transition from a place
+    """
+    r = re.compile(r'  <arc place="{}" transition="{}" type="PlaceTransition".*?</arc> *\n(?: *\n)*'.format(place, transition),
+                   re.S)
+    content, count = r.subn("", content)
+    if count != 1:
+        raise Exception("No arc from place {} to transition {} in the hardware model".format(place, transition))
+    return content
+
+
+def write_model(input_file, output_file, policy, slot):
+    """
+    Write the hardware model with the bus arbitration: a core requesting the
+    bus for a refill (ICacheMIss) or a memory access (Mem, and MemBuffered
+    with a prefetch buffer) first registers its request in the arbiter, then
+    only the core granted by the arbiter can take the bus.
+    With tdma, a core takes the bus whatever the time left in its slot, so
+    an access granted at the end of a slot runs into the next one, and the
+    slots keep following each other once the cores have ended.
+    :param input_file: hardware model (twoCoresModel3_empty or a variant)
+    :param output_file: hardware model with the arbitration
+    :param policy: arbitration policy
+    :param slot: with tdma, length of a slot in cycles
+    :return: None
+    """
+    f = open(input_file, "r")
+    content = f.read()
+    f.close()
+
+    fetching = find_id(content, "place", "P8")  # waiting for the cache
+    fetched = find_id(content, "place", "P9")
+    execution_free = find_id(content, "place", "P4")
+    miss = find_id(content, "transition", "ICacheMIss")
+    mems = [find_id(content, "transition", "Mem")]
+    if 'identifier="MemBuffered"' in content:
+        mems.append(find_id(content, "transition", "MemBuffered"))
+    miss_pending_id, mem_pending_id, slot_place_id = free_ids(content, "place", 3)
+    miss_request_id, mem_request_id, slot_transition_id = free_ids(content, "transition", 3)
+
+    # the guards still hold while the request is pending
+    granted = " && (arb.grant #eqeq $any)"
+    take = lambda u: u + "\nbusTake(arb, $any);"
+    content = set_transition(content, "ICacheMIss", guard=lambda g: g + granted, update=take)
+    content = set_transition(content, "Mem", guard=lambda g: g + granted, update=take)
+    if len(mems) > 1:
+        content = set_transition(content, "MemBuffered", guard=lambda g: g + granted, update=take)
+
+    # a miss waits in MissPending, a memory access in MemPending
+    content = move_arc(content, fetching, miss, miss_pending_id)
+    for mem in mems:
+        content = move_arc(content, fetched, mem, mem_pending_id)
+        content = remove_arc(content, execution_free, mem)
+
+    places = place(miss_pending_id, "MissPending", 0, 511.0, 241.0)
+    places += place(mem_pending_id, "MemPending", 0, 871.0, 271.0)
+    transitions = transition(miss_request_id, "MissRequest", 0, request_priority,
+                             "(doFetch[$any] #eqeq 0) && (isHit[$any] #eqeq 0)",
+                             "busRequest(arb, $any);", 451.0, 211.0)
+    transitions += transition(mem_request_id, "MemRequest", 0, request_priority,
+                              "(doFetch[$any] #eqeq 0) && (ac[$any] #greater 0)",
+                              "busRequest(arb, $any);", 811.0, 241.0)
+    arcs = arc(fetching, miss_request_id, False) + arc(miss_pending_id, miss_request_id, True)
+    arcs += arc(fetched, mem_request_id, False) + arc(execution_free, mem_request_id, False)
+    arcs += arc(mem_pending_id, mem_request_id, True)
+    if policy == "tdma":
+        # the slots follow each other, the token of Slot only gives the time
+        places += place(slot_place_id, "Slot", 1, 691.0, 361.0)
+        transitions += transition(slot_transition_id, "NextSlot", slot, request_priority,
+                                  "", "busNextSlot(arb);", 751.0, 361.0)
+        arcs += arc(slot_place_id, slot_transition_id, False) + arc(slot_place_id, slot_transition_id, True)
+
+    first_transition = content.index("  <transition ")
+    content = content[:first_transition] + places + content[first_transition:]
+    first_arc = content.index("  <arc ")
+    content = content[:first_arc] + transitions + content[first_arc:]
+    end_arcs = content.index("  <timedCost>")
+    content = content[:end_arcs] + arcs + content[end_arcs:]
+
+    f = open(output_file, "w")
+    f.write(content)
+    f.close()
+
+
+def arbiter_sections(policy, cores):
+    """
+    Declaration sections of the arbiter, spliced in the "// @begin arbiter"
+    and "// @begin initArbiter" regions of the declarations by
+    extract_variables.py. The arbiter state only keeps what the policy needs.
+    :param policy: arbitration policy
+    :param cores: number of cores
+    :return: sections, in the format of extract --decl
+    """
+    fields = "  uint8_t[{}] waiting; // the core requests the bus\n".format(cores)
+    fields += "  uint8_t grant; // core taking the bus once free, {} if none\n".format(cores)
+    if policy == "rr":
+        fields += "  uint8_t last; // core that took the bus last\n"
+    elif policy == "fifo":
+        fields += "  uint8_t[{}] position; // in the queue of the waiting cores\n".format(cores)
+    elif policy == "tdma":
+        fields += "  uint8_t slot; // core of the current slot\n"
+
+    s = "// @section arbiter\n"
+    s += "// bus arbitration: {} among {} cores\n".format(policy, cores)
+    s += "typedef struct {\n" + fields + "} arbiter_t;\n\n"
+
+    s += "void initArbiter(arbiter_t &arb) {\n"
+    s += "  for (int k = 0; k < {}; k++) {{\n".format(cores)
+    s += "    arb.waiting[k] = 0;\n"
+    if policy == "fifo":
+        s += "    arb.position[k] = 0;\n"
+    s += "  }\n"
+    s += "  arb.grant = {};\n".format(cores)
+    if policy == "rr":
+        s += "  arb.last = {};\n".format(cores - 1)
+    elif policy == "tdma":
+        s += "  arb.slot = 0;\n"
+    s += "}\n\n"
+
+    s += "/* grant the bus to one of the waiting cores */\n"
+    s += "void busArbitrate(arbiter_t &arb) {\n"
+    s += "  arb.grant = {};\n".format(cores)
+    if policy == "priority":
+        # the lowest core first
+        s += "  for (int k = {}; k >= 0; k--) {{\n".format(cores - 1)
+        s += "    if (arb.waiting[k] == 1) {\n"
+        s += "      arb.grant = k;\n    }\n  }\n"
+    elif policy == "rr":
+        # the first core after the last one, the last one at the end
+        s += "  for (int i = {}; i >= 1; i--) {{\n".format(cores)
+        s += "    int k = arb.last + i;\n"
+        s += "    if (k >= {}) {{\n      k = k - {};\n    }}\n".format(cores, cores)
+        s += "    if (arb.waiting[k] == 1) {\n"
+        s += "      arb.grant = k;\n    }\n  }\n"
+    elif policy == "fifo":
+        s += "  for (int k = 0; k < {}; k++) {{\n".format(cores)
+        s += "    if (arb.waiting[k] == 1 && arb.position[k] == 0) {\n"
+        s += "      arb.grant = k;\n    }\n  }\n"
+    else:
+        s += "  if (arb.waiting[arb.slot] == 1) {\n"
+        s += "    arb.grant = arb.slot;\n  }\n"
+    s += "}\n\n"
+
+    s += "void busRequest(arbiter_t &arb, int core) {\n"
+    if policy == "fifo":
+        # at the end of the queue
+        s += "  int position = 0;\n"
+        s += "  for (int k = 0; k < {}; k++) {{\n".format(cores)
+        s += "    position = position + arb.waiting[k];\n  }\n"
+        s += "  arb.position[core] = position;\n"
+    s += "  arb.waiting[core] = 1;\n"
+    s += "  busArbitrate(arb);\n}\n\n"
+
+    s += "void busTake(arbiter_t &arb, int core) {\n"
+    s += "  arb.waiting[core] = 0;\n"
+    if policy == "rr":
+        s += "  arb.last = core;\n"
+    elif policy == "fifo":
+        s += "  for (int k = 0; k < {}; k++) {{\n".format(cores)
+        s += "    if (arb.waiting[k] == 1) {\n"
+        s += "      arb.position[k] = arb.position[k] - 1;\n    }\n  }\n"
+        s += "  arb.position[core] = 0;\n"
+    s += "  busArbitrate(arb);\n}\n"
+
+    if policy == "tdma":
+        s += "\nvoid busNextSlot(arbiter_t &arb) {\n"
+        s += "  arb.slot = arb.slot + 1;\n"
+        s += "  if (arb.slot == {}) {{\n    arb.slot = 0;\n  }}\n".format(cores)
+        s += "  busArbitrate(arb);\n}\n"
+
+    s += "// @section initArbiter\n"
+    s += "  arbiter_t arb;\n"
+    s += "  initArbiter(arb);\n"
+    return s
+
+
+if __name__ == "__main__":
+    # Parser
+    parser = argparse.ArgumentParser(
+        prog='arbiter',
+        description='Write a hardware model whose bus is granted by an arbitration policy')
+    parser.add_argument('policy', choices=policies,
+                        help='priority (the lowest core first), rr (round-robin), fifo (the oldest request first) or tdma (the core of the current slot)')
+    parser.add_argument('--cores', type=int, default=2,
+                        help='number of cores (default: 2)')
+    parser.add_argument('--slot', type=int, default=20,
+                        help='with tdma, length of a slot in cycles (default: 20)')
+    parser.add_argument('--input', required=True,
+                        help='hardware model')
+    parser.add_argument('--output', required=True,
+                        help='hardware model with the arbitration')
+    parser.add_argument('--sections', required=True,
+                        help='file of the arbiter declaration sections, for extract_variables.py -splice')
+    args = parser.parse_args()
+
+    write_model(args.input, args.output, args.policy, args.slot)
+    f = open(args.sections, "w")
+    f.write(arbiter_sections(args.policy, args.cores))
+    f.close()
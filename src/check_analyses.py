@@ -0,0 +1,287 @@
+import argparse
+import os
+import random
+import re
+import subprocess
+import sys
+import tempfile
+
+# firing intervals of the timed transitions in hardware.xml (twoCoresModel3_empty)
+delays = {"ICacheHit": 1, "T14": 10, "T4": 1, "T3": 4}
+
+conditions = {"beq": 0, "bne": 1, "bcs": 2, "bcc": 3, "bls": 9, "bge": 10, "blt": 11, "ble": 13}
+
+
+def encode(kind, a, address, labels):
+    """
+    Thumb encoding of an instruction of the random programs
+    :return: code, on 32 bits for bl and mul
+    """
+    if kind == "push":
+        return 0xb400 | (1 << 8) | sum(1 << r for r in a[0])
+    if kind == "pop":
+        return 0xbc00 | (1 << 8) | sum(1 << r for r in a[0])
+    if kind == "subsp":
+        return 0xb080 | (a[0] // 4)
+    if kind == "addsp":
+        return 0xb000 | (a[0] // 4)
+    if kind == "addrsp":
+        return 0xa800 | (a[0] << 8) | a[1]
+    if kind == "mov":
+        return 0x4600 | ((a[0] >> 3) << 7) | (a[1] << 3) | (a[0] & 7)
+    if kind in ("movi", "cmpi", "addi", "subi"):
+        return {"movi": 0x2000, "cmpi": 0x2800, "addi": 0x3000, "subi": 0x3800}[kind] | (a[0] << 8) | a[1]
+    if kind in ("str", "ldr"):
+        return (0x6000 if kind == "str" else 0x6800) | ((a[2] // 4) << 6) | (a[1] << 3) | a[0]
+    if kind in ("strb", "ldrb"):
+        return (0x7000 if kind == "strb" else 0x7800) | (a[2] << 6) | (a[1] << 3) | a[0]
+    if kind == "addr":
+        return 0x1800 | (a[2] << 6) | (a[1] << 3) | a[0]
+    if kind == "cmpr":
+        return 0x4280 | (a[1] << 3) | a[0]
+    if kind == "ands":
+        return 0x4000 | (a[1] << 3) | a[0]
+    if kind == "muls":
+        return 0x4340 | (a[1] << 3) | a[0]
+    if kind == "lsl":
+        return (a[2] << 6) | (a[1] << 3) | a[0]
+    if kind == "uxtb":
+        return 0xb2c0 | (a[1] << 3) | a[0]
+    if kind == "nop":
+        return 0xbf00
+    if kind in conditions:
+        return 0xd000 | (conditions[kind] << 8) | (((labels[a[0]] - address - 4) // 2) & 0xff)
+    if kind == "b":
+        return 0xe000 | (((labels[a[0]] - address - 4) // 2) & 0x7ff)
+    if kind == "bl":
+        offset = (labels[a[0]] - address - 4) & 0xffffffff
+        s = offset >> 31
+        j1 = 1 - (((offset >> 23) & 1) ^ s)
+        j2 = 1 - (((offset >> 22) & 1) ^ s)
+        return ((0xf000 | (s << 10) | ((offset >> 12) & 0x3ff)) << 16) | \
+            0xd000 | (j1 << 13) | (j2 << 11) | ((offset >> 1) & 0x7ff)
+    if kind == "mul":
+        return 0xfb00f000 | (a[1] << 16) | (a[0] << 8) | a[2]
+    raise ValueError(kind)
+
+
+def assemble(program, start=0x8000):
+    """
+    Program in the format of extract.awk
+    :param program: list of (kind, arguments), a label being ("label", name)
+    :return: lines, labels
+    """
+    labels = {}
+    address = start
+    for kind, a in program:
+        if kind == "label":
+            labels[a] = address
+        else:
+            address += 4 if kind in ("bl", "mul") else 2
+    lines = []
+    address = start
+    for kind, a in program:
+        if kind == "label":
+            continue
+        code = encode(kind, a, address, labels)
+        if kind in ("bl", "mul"):
+            lines.append("a:{:x}:{:04x}{:04x}".format(address, code >> 16, code & 0xffff))
+            address += 4
+        else:
+            lines.append("t:{:x}:{:04x}".format(address, code))
+            address += 2
+    return lines, labels
+
+
+def random_program(rng):
+    """
+    Random program with nested counted loops, forward branches, a function
+    call, memory accesses in its frame and multiplications. r0-r5 are its
+    inputs, r6 the loop counter and r7 the frame.
+    :return: lines in the format of extract.awk, stop address
+    """
+    p = [("push", ([4, 5, 6, 7],)), ("subsp", (40,)), ("addrsp", (7, 0)), ("bl", ("function",))]
+    loops = []
+    label = 0
+    for k in range(rng.randint(10, 60)):
+        c = rng.random()
+        if c < 0.08 and not loops:
+            p += [("movi", (6, rng.randint(1, 6))), ("label", "loop{}".format(k))]
+            loops.append(k)
+        elif c < 0.14 and loops:
+            p += [("subi", (6, 1)), ("cmpi", (6, 0)), ("bne", ("loop{}".format(loops.pop()),))]
+        elif c < 0.22:
+            p += [(rng.choice(list(conditions)), ("f{}".format(label),)),
+                  ("movi", (rng.randint(0, 5), rng.randint(0, 255))), ("label", "f{}".format(label))]
+            label += 1
+        else:
+            r, s = rng.randint(0, 5), rng.randint(0, 5)
+            op = rng.choice(["movi", "cmpi", "addi", "subi", "str", "ldr", "strb", "ldrb", "addr", "cmpr",
+                             "ands", "lsl", "uxtb", "muls", "mul", "nop"])
+            if op in ("movi", "cmpi", "addi", "subi"):
+                p.append((op, (r, rng.randint(0, 255))))
+            elif op in ("str", "ldr"):
+                p.append((op, (r, 7, rng.randint(0, 9) * 4)))
+            elif op in ("strb", "ldrb"):
+                p.append((op, (r, 7, rng.randint(0, 31))))
+            elif op in ("addr", "mul"):
+                p.append((op, (r, s, rng.randint(0, 5))))
+            elif op == "lsl":
+                p.append((op, (r, s, rng.randint(0, 31))))
+            elif op == "nop":
+                p.append((op, ()))
+            else:
+                p.append((op, (r, s)))
+    while loops:
+        p += [("subi", (6, 1)), ("cmpi", (6, 0)), ("bne", ("loop{}".format(loops.pop()),))]
+    p += [("label", "end"), ("mov", (13, 7)), ("addsp", (40,)), ("pop", ([4, 5, 6, 7],))]
+    p += [("label", "function"), ("push", ([7],)), ("movi", (6, rng.randint(1, 4))), ("label", "wait"),
+          ("subi", (6, 1)), ("bne", ("wait",)), ("pop", ([7],))]
+    lines, labels = assemble(p)
+    return lines, labels["end"]
+
+
+def extract(binary, program, *args):
+    """
+    Run extract on the program
+    :return: standard output
+    """
+    r = subprocess.run([binary] + [str(a) for a in args], input="\n".join(program) + "\n",
+                       capture_output=True, text=True)
+    if r.returncode > 1 or r.stderr:
+        raise RuntimeError("extract {}: {}".format(" ".join(str(a) for a in args), r.stderr))
+    return r.stdout
+
+
+def cycles(line):
+    m = re.match(r"[0-9a-f]+: (\d+) cycles", line)
+    return int(m.groups()[0]) if m else None
+
+
+def check_program(binary, rng, program, stop, inputs, mcpu, work):
+    """
+    Cross-check the analyses on one program, each input giving r0 (the
+    other registers are fixed):
+      - the translated simulator (--translate) and the replay of the trace
+        (--trace, --replay) give the times of --simulate
+      - --check on one core gives the minimum and maximum of --simulate
+      - with the point delays of hardware.xml, --zones gives BCET = WCET =
+        the time of --simulate, and the intervals of hardware.xml read with
+        --input are the ones of --delay
+      - with random intervals, the BCET and WCET of --zones are the times of
+        the replay with all the eft and with all the lft
+      - the times of --simulate are within the BCET and WCET of --static
+    :return: list of the failed checks
+    """
+    failures = []
+    stop = "0x{:x}".format(stop)
+    cpu = ["--mcpu", mcpu] if mcpu else []
+    fixed = []
+    for r in range(1, 6):
+        fixed += ["--init", "r{}={}".format(r, rng.randint(0, 255))]
+    cases = os.path.join(work, "cases.txt")
+    with open(cases, "w") as f:
+        f.write("".join("r0={}\n".format(v) for v in range(inputs)))
+
+    simulated = extract(binary, program, "--simulate", "--cases", cases, *(fixed + cpu + [stop])).splitlines()
+    times = [cycles(line) for line in simulated]
+    stopped = [t for t in times if t is not None]
+
+    source = os.path.join(work, "sim.cpp")
+    simulator = os.path.join(work, "sim")
+    extract(binary, program, "--translate", source, *(fixed + cpu + [stop]))
+    subprocess.run(["g++", "-O2", "-fwrapv", source, "-o", simulator], check=True)
+    init = [x for x in fixed if x != "--init"]
+    translated = subprocess.run([simulator, "--cases", cases] + init, capture_output=True, text=True)
+    if translated.stdout.splitlines() != simulated:
+        failures.append("--translate differs from --simulate")
+
+    if not mcpu:
+        trace = os.path.join(work, "prog.trace")
+        extract(binary, program, "--simulate", "--cases", cases, "--trace", trace, *(fixed + [stop]))
+        if [cycles(line) for line in extract(binary, "", "--replay", trace).splitlines()] != times:
+            failures.append("--replay differs from --simulate")
+
+    if stopped:
+        checked = extract(binary, program, "--check", "--sweep", "r0=0..{}".format(inputs - 1),
+                          *(fixed + cpu + [stop]))
+        bounds = [int(x) for x in re.findall(r"(?:min|max) (\d+) cycles", checked)]
+        if bounds != [min(stopped), max(stopped)]:
+            failures.append("--check gives {} for [{}, {}]".format(bounds, min(stopped), max(stopped)))
+
+        static = extract(binary, program, "--static", "--sweep", "r0=0..{}".format(inputs - 1),
+                         *(fixed + cpu + [stop]))
+        m = re.search(r"(?:WCET <=|counts) (\d+) cycles.*BCET >= (\d+) cycles", static)
+        if m is None or not int(m.groups()[1]) <= min(stopped) <= max(stopped) <= int(m.groups()[0]):
+            failures.append("--static bounds {} out of [{}, {}]".format(
+                m.groups() if m else static.strip(), min(stopped), max(stopped)))
+
+    if times[0] is None:
+        return failures
+    zones = extract(binary, program, "--zones", "--init", "r0=0", *(fixed + cpu + [stop]))
+    if re.findall(r"[BW]CET (\d+)", zones) != [str(times[0])] * 2:
+        failures.append("--zones gives {} for {}".format(zones.strip(), times[0]))
+    if mcpu:
+        return failures
+
+    intervals = {}
+    for name, delay in delays.items():
+        eft = rng.randint(max(0, delay - 3), delay)
+        intervals[name] = (eft, eft + rng.randint(0, 4))
+    model = os.path.join(work, "hardware.xml")
+    with open(model, "w") as f:
+        for name, (eft, lft) in intervals.items():
+            f.write("<transition id=\"{}\" identifier=\"{}\" eft=\"{}\" lft=\"{}\"></transition>\n".format(
+                len(name), name, eft, lft))
+    given = []
+    for name, (eft, lft) in intervals.items():
+        given += ["--delay", "{}={},{}".format(name, eft, lft)]
+    zones = extract(binary, program, "--zones", "--init", "r0=0", *(fixed + given + [stop]))
+    if extract(binary, program, "--zones", "--init", "r0=0", "--input", model, *(fixed + [stop])) != zones:
+        failures.append("--zones --input differs from --delay")
+    m = re.search(r"BCET (\d+) cycles.*WCET (\d+) cycles.*zones(.*)", zones)
+    trace = os.path.join(work, "one.trace")
+    extract(binary, program, "--simulate", "--init", "r0=0", "--trace", trace, *(fixed + [stop]))
+    replayed = []
+    for bound in range(2):
+        args = []
+        for name, interval in intervals.items():
+            args += ["--delay", "{}={}".format(name, interval[bound])]
+        replayed.append(str(cycles(extract(binary, "", "--replay", trace, *args))))
+    if m is None or "joined" in m.groups()[2]:
+        return failures
+    if list(m.groups()[:2]) != replayed:
+        failures.append("--zones gives {} with {}, the replays {}".format(m.groups()[:2], intervals, replayed))
+    return failures
+
+
+if __name__ == "__main__":
+    # Parser
+    parser = argparse.ArgumentParser(
+        prog='check_analyses',
+        description='Cross-check the simulation, translation, replay, model checking, zone and static '
+                    'analyses of extract on random programs')
+    parser.add_argument('--extract', default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "extract"),
+                        help='extract binary (default: src/extract)')
+    parser.add_argument('--programs', type=int, default=60,
+                        help='number of random programs (default: 60)')
+    parser.add_argument('--inputs', type=int, default=16,
+                        help='values of r0 per program (default: 16)')
+    parser.add_argument('--seed', type=int, default=0,
+                        help='seed of the first program (default: 0)')
+    parser.add_argument('--mcpu', default=None,
+                        help='cycle table of extract --mcpu with exact cycles, the replay and the intervals '
+                             'being skipped')
+    args = parser.parse_args()
+
+    failed = 0
+    with tempfile.TemporaryDirectory() as work:
+        for seed in range(args.seed, args.seed + args.programs):
+            rng = random.Random(seed)
+            program, stop = random_program(rng)
+            failures = check_program(args.extract, rng, program, stop, args.inputs, args.mcpu, work)
+            for failure in failures:
+                print("program {}: {}".format(seed, failure))
+            failed += 1 if failures else 0
+    print("{} of {} programs checked without failure".format(args.programs - failed, args.programs))
+    sys.exit(1 if failed else 0)
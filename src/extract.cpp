@@ -1,10 +1,24 @@
+#include <algorithm>
+#include <atomic>
+#include <ctype.h>
+#include <fcntl.h>
 #include <filesystem>
+#include <functional>
+#include <getopt.h>
 #include <limits.h>
+#include <map>
+#include <math.h>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
 #include <vector>
 
 using namespace std;
@@ -22,32 +36,566 @@ public:
 
 /*===========================================================================*/
 
+/* Hexadecimal and one decimal (positions in the net) integer formats */
+struct Hex_t {
+  uint32_t value;
+  explicit Hex_t(const uint32_t inValue) : value(inValue) {}
+};
+
+struct Fixed_t {
+  double value;
+  explicit Fixed_t(const double inValue) : value(inValue) {}
+};
+
+/*
+ * Append only output buffer. The generated code and the net are built in
+ * memory, integers are formatted by hand and the content is written to the
+ * file descriptor in large blocks instead of one printf per element. A
+ * buffer without file descriptor only grows and is copied by its owner.
+ */
+class Buffer_t {
+  char *mData;
+  size_t mSize;
+  size_t mCapacity;
+  int mFd;
+
+  static const size_t sBlockSize = 1 << 16;
+
+  char *grow(const size_t len) {
+    if (mSize + len > mCapacity) {
+      flush();
+      while (mSize + len > mCapacity)
+        mCapacity = mCapacity == 0 ? sBlockSize : mCapacity * 2;
+      mData = (char *)realloc(mData, mCapacity);
+      if (mData == NULL) {
+        perror("extract");
+        exit(1);
+      }
+    }
+    char *end = mData + mSize;
+    mSize += len;
+    return end;
+  }
+
+  Buffer_t &unsignedDec(uint64_t value, const bool negative) {
+    char digits[21];
+    char *d = digits + sizeof(digits);
+    do {
+      *--d = '0' + value % 10;
+      value /= 10;
+    } while (value != 0);
+    if (negative)
+      *--d = '-';
+    const size_t len = digits + sizeof(digits) - d;
+    memcpy(grow(len), d, len);
+    return *this;
+  }
+
+  Buffer_t &signedDec(const int64_t value) {
+    return unsignedDec(value < 0 ? -(uint64_t)value : value, value < 0);
+  }
+
+public:
+  Buffer_t(const int inFd = -1)
+      : mData(NULL), mSize(0), mCapacity(0), mFd(inFd) {}
+  Buffer_t(const Buffer_t &) = delete;
+  Buffer_t &operator=(const Buffer_t &) = delete;
+  ~Buffer_t() {
+    flush();
+    free(mData);
+  }
+
+  const char *data() const { return mData; }
+  size_t size() const { return mSize; }
+  void clear() { mSize = 0; }
+
+  /* write the content to the file descriptor, if any */
+  void flush() {
+    if (mFd < 0)
+      return;
+    size_t done = 0;
+    while (done < mSize) {
+      const ssize_t written = write(mFd, mData + done, mSize - done);
+      if (written < 0) {
+        perror("extract");
+        exit(1);
+      }
+      done += written;
+    }
+    mSize = 0;
+  }
+
+  Buffer_t &append(const char *inData, const size_t len) {
+    memcpy(grow(len), inData, len);
+    return *this;
+  }
+
+  Buffer_t &operator<<(const char *str) { return append(str, strlen(str)); }
+  Buffer_t &operator<<(const char c) {
+    *grow(1) = c;
+    return *this;
+  }
+  Buffer_t &operator<<(const Buffer_t &other) {
+    return append(other.mData, other.mSize);
+  }
+  Buffer_t &operator<<(const int value) { return signedDec(value); }
+  Buffer_t &operator<<(const long value) { return signedDec(value); }
+  Buffer_t &operator<<(const long long value) { return signedDec(value); }
+  Buffer_t &operator<<(const unsigned value) {
+    return unsignedDec(value, false);
+  }
+  Buffer_t &operator<<(const unsigned long value) {
+    return unsignedDec(value, false);
+  }
+  Buffer_t &operator<<(const unsigned long long value) {
+    return unsignedDec(value, false);
+  }
+  Buffer_t &operator<<(const Hex_t hex) {
+    static const char digits[] = "0123456789abcdef";
+    char buf[8];
+    char *d = buf + sizeof(buf);
+    uint32_t value = hex.value;
+    do {
+      *--d = digits[value & 0xF];
+      value >>= 4;
+    } while (value != 0);
+    return append(d, buf + sizeof(buf) - d);
+  }
+  Buffer_t &operator<<(const Fixed_t fixed) {
+    const bool negative = fixed.value < 0;
+    const uint64_t tenths =
+        (uint64_t)((negative ? -fixed.value : fixed.value) * 10 + 0.5);
+    if (negative && tenths != 0)
+      *this << '-';
+    unsignedDec(tenths / 10, false);
+    *this << '.';
+    return *this << (char)('0' + tenths % 10);
+  }
+};
+
+/*===========================================================================*/
+
+/*
+ * Abstract value of a register or of a memory word, as computed by the data
+ * flow analysis of the generated code. A value is unknown (TOP), a constant
+ * or an offset from the initial stack pointer (dataStart is not known by
+ * extract). taint is set if the value may depend on a secret input.
+ */
+class AbsValue_t {
+public:
+  enum Kind_t { TOP, CONST, STACK };
+  Kind_t kind;
+  int32_t value;
+  bool taint;
+
+  AbsValue_t() : kind(TOP), value(0), taint(false) {}
+  AbsValue_t(const Kind_t inKind, const int32_t inValue, const bool inTaint)
+      : kind(inKind), value(inValue), taint(inTaint) {}
+  static AbsValue_t top(const bool inTaint) {
+    return AbsValue_t(TOP, 0, inTaint);
+  }
+  static AbsValue_t constant(const int32_t inValue) {
+    return AbsValue_t(CONST, inValue, false);
+  }
+
+  bool operator==(const AbsValue_t &other) const {
+    return kind == other.kind && value == other.value && taint == other.taint;
+  }
+  bool known() const { return kind != TOP; }
+
+  /* least upper bound, returns true if the value changed */
+  bool join(const AbsValue_t &other) {
+    const AbsValue_t old = *this;
+    taint = taint || other.taint;
+    if (kind != other.kind || value != other.value) {
+      kind = TOP;
+      value = 0;
+    }
+    return !(old == *this);
+  }
+
+  AbsValue_t plus(const AbsValue_t &other) const {
+    const bool t = taint || other.taint;
+    const int32_t sum = (int32_t)((uint32_t)value + (uint32_t)other.value);
+    if (kind == CONST && other.kind == CONST)
+      return AbsValue_t(CONST, sum, t);
+    if (kind == STACK && other.kind == CONST)
+      return AbsValue_t(STACK, sum, t);
+    if (kind == CONST && other.kind == STACK)
+      return AbsValue_t(STACK, sum, t);
+    return top(t);
+  }
+  AbsValue_t plus(const int32_t imm) const { return plus(constant(imm)); }
+
+  /* key of the memory word holding the byte at this address */
+  uint64_t cell() const {
+    return ((uint64_t)kind << 32) | (uint32_t)(value & ~3);
+  }
+};
+
+/* memory access done during an abstract execution */
+class AbsAccess_t {
+public:
+  AbsValue_t address;
+  bool store;
+  bool whole; // false for byte and halfword accesses
+  bool taint; // taint of the stored value
+};
+
+/*
+ * Abstract state of a core: registers, taint of the status register and
+ * memory words indexed by AbsValue_t::cell(). The words that are not in mem
+ * have the value memOther, except the secret ones which are tainted.
+ */
+class AbsState_t {
+public:
+  AbsValue_t r[16];
+  bool srTaint;
+  map<uint64_t, AbsValue_t> mem;
+  AbsValue_t memOther;
+  vector<AbsAccess_t> *accesses; // if not NULL, log of the memory accesses
+
+  /* [first, last] byte address ranges of the secret memory */
+  static vector<pair<uint32_t, uint32_t>> sSecretMem;
+
+  AbsState_t() : srTaint(false), accesses(NULL) {}
+
+  static bool isSecret(const uint64_t cell) {
+    if ((cell >> 32) != AbsValue_t::CONST)
+      return false;
+    const uint32_t first = (uint32_t)cell;
+    for (auto i = sSecretMem.begin(); i != sSecretMem.end(); ++i)
+      if (first <= i->second && first + 3 >= i->first)
+        return true;
+    return false;
+  }
+
+  AbsValue_t lookup(const uint64_t cell) const {
+    auto i = mem.find(cell);
+    if (i != mem.end())
+      return i->second;
+    AbsValue_t v = memOther;
+    v.taint = v.taint || isSecret(cell);
+    return v;
+  }
+
+  bool regsTaint(uint16_t regs) const {
+    for (uint8_t reg = 0; regs != 0; reg++, regs >>= 1)
+      if ((regs & 1) && r[reg].taint)
+        return true;
+    return false;
+  }
+
+  void writeRegs(uint16_t regs, const AbsValue_t &v) {
+    for (uint8_t reg = 0; regs != 0; reg++, regs >>= 1)
+      if (regs & 1)
+        r[reg] = v;
+  }
+
+  AbsValue_t load(const AbsValue_t &address, const bool whole) {
+    if (accesses != NULL)
+      accesses->push_back({address, false, whole, false});
+    if (!address.known()) {
+      bool t = address.taint || memOther.taint || !sSecretMem.empty();
+      for (auto i = mem.begin(); i != mem.end(); ++i)
+        t = t || i->second.taint;
+      return AbsValue_t::top(t);
+    }
+    AbsValue_t v = lookup(address.cell());
+    v.taint = v.taint || address.taint;
+    return whole ? v : AbsValue_t::top(v.taint);
+  }
+
+  void store(const AbsValue_t &address, const AbsValue_t &value,
+             const bool whole) {
+    if (accesses != NULL)
+      accesses->push_back({address, true, whole, value.taint});
+    const bool t = value.taint || address.taint;
+    if (!address.known()) {
+      for (auto i = mem.begin(); i != mem.end(); ++i)
+        i->second = AbsValue_t::top(i->second.taint || t);
+      memOther = AbsValue_t::top(memOther.taint || t);
+      return;
+    }
+    const uint64_t cell = address.cell();
+    if (whole) {
+      mem[cell] = value;
+      mem[cell].taint = t;
+    } else {
+      mem[cell] = AbsValue_t::top(lookup(cell).taint || t);
+    }
+  }
+
+  /* least upper bound, returns true if the state changed */
+  bool join(const AbsState_t &other) {
+    bool changed = false;
+    for (uint8_t reg = 0; reg < 16; reg++)
+      changed = r[reg].join(other.r[reg]) || changed;
+    if (other.srTaint && !srTaint) {
+      srTaint = true;
+      changed = true;
+    }
+    for (auto i = other.mem.begin(); i != other.mem.end(); ++i) {
+      if (mem.find(i->first) == mem.end()) {
+        mem[i->first] = lookup(i->first);
+        changed = true;
+      }
+    }
+    for (auto i = mem.begin(); i != mem.end(); ++i)
+      changed = i->second.join(other.lookup(i->first)) || changed;
+    changed = memOther.join(other.memOther) || changed;
+    return changed;
+  }
+};
+
+vector<pair<uint32_t, uint32_t>> AbsState_t::sSecretMem;
+
+/*===========================================================================*/
+
+/*
+ * Concrete state of a core and of its memory for the simulation. The types
+ * and the helpers are those of declarations.c so that an instruction
+ * computes the same values as its generated function: registers and memory
+ * words are int, the memory is the 30 words of mem_t from dataStart.
+ * An access out of mem_t or a division by zero, which stop Roméo, sets
+ * fault. If dataTrace is set, the data accesses are appended to it as
+ * address << 1 | write (a 16 or 8 bit write is one access).
+ */
+class Machine_t {
+public:
+  static const uint32_t sMemWords = 30;
+  static const uint32_t sCacheLines = 16;
+  static const uint32_t sDefaultDataStart = 98432;
+  static const int32_t sNmask = 1 << 0;
+  static const int32_t sZmask = 1 << 1;
+  static const int32_t sCmask = 1 << 2;
+  static const int32_t sVmask = 1 << 3;
+  static const int32_t sValid = INT32_MIN;
+  static const int32_t sTagMask = INT32_MAX;
+
+  int32_t r[16];
+  int32_t sr;
+  int32_t mem[sMemWords];
+  int32_t iCache[sCacheLines];
+  uint32_t dataStart;
+  bool fault;
+  uint32_t faultAddress;
+  vector<uint64_t> *dataTrace; // not part of the state
+
+  /* initially block of declarations.c, without initConsts() */
+  explicit Machine_t(const uint32_t inDataStart = sDefaultDataStart)
+      : sr(0), dataStart(inDataStart), fault(false), faultAddress(0),
+        dataTrace(NULL) {
+    for (uint32_t i = 0; i < 16; i++)
+      r[i] = i;
+    r[13] = dataStart + 100;
+    for (uint32_t i = 0; i < sMemWords; i++)
+      mem[i] = i;
+    for (uint32_t i = 0; i < sCacheLines; i++)
+      iCache[i] = 0;
+  }
+
+  static uint64_t mix(uint64_t h, const uint64_t v) {
+    h = (h ^ v) * 0xbf58476d1ce4e5b9ULL;
+    return h ^ (h >> 31);
+  }
+  /* fingerprint of the state */
+  uint64_t hash() const {
+    uint64_t h = mix(0, (uint32_t)sr);
+    for (uint32_t i = 0; i < 16; i++)
+      h = mix(h, (uint32_t)r[i]);
+    for (uint32_t i = 0; i < sMemWords; i++)
+      h = mix(h, (uint32_t)mem[i]);
+    for (uint32_t i = 0; i < sCacheLines; i++)
+      h = mix(h, (uint32_t)iCache[i]);
+    return h;
+  }
+
+  void setFault(const uint32_t address) {
+    if (!fault) {
+      fault = true;
+      faultAddress = address;
+    }
+  }
+
+  /* returns 1 on a hit and 0 on a miss, as cacheAccess() of declarations.c */
+  int32_t cacheAccess(const int32_t address) {
+    const int32_t line = (address >> 5) & (sCacheLines - 1);
+    const int32_t tag = (address >> 9) & sTagMask;
+    if ((iCache[line] & sValid) != 0 && (iCache[line] & sTagMask) == tag)
+      return 1;
+    iCache[line] = sValid | tag;
+    return 0;
+  }
+
+  void updateSR(const uint64_t val, const uint32_t op1, const uint32_t op2) {
+    sr = val == 0 ? sr | sZmask : sr & ~sZmask;
+    sr = ((val >> 31) & 1) ? sr | sNmask : sr & ~sNmask;
+    sr = ((val >> 32) & 1) ? sr | sCmask : sr & ~sCmask;
+    sr = sr & ~sVmask;
+    /* same precedence as the tests of declarations.c */
+    if ((op1 >> 31) & (1 == (op2 >> 31)) & 1)
+      if ((op1 >> 31) & (1 != (val >> 31)) & 1)
+        sr = sr | sVmask;
+  }
+
+  void record(const uint32_t address, const bool write) {
+    if (dataTrace != NULL)
+      dataTrace->push_back((uint64_t)address << 1 | write);
+  }
+  uint32_t load(const uint32_t address) {
+    const uint32_t index = (address - dataStart) / 4;
+    if (index >= sMemWords) {
+      setFault(address);
+      return 0;
+    }
+    return mem[index];
+  }
+  void store(const uint32_t address, const uint32_t data) {
+    const uint32_t index = (address - dataStart) / 4;
+    if (index >= sMemWords) {
+      setFault(address);
+      return;
+    }
+    mem[index] = data;
+  }
+
+  uint32_t memRead(const uint32_t address) {
+    record(address, false);
+    return load(address);
+  }
+  void memWrite(const uint32_t address, const uint32_t data) {
+    record(address, true);
+    store(address, data);
+  }
+  uint16_t memRead16(const uint32_t address) {
+    const int32_t data = memRead(address);
+    return (data >> ((address & 1) * 16)) & 0x0000FFFF;
+  }
+  uint8_t memRead8(const uint32_t address) {
+    const int32_t data = memRead(address);
+    return (data >> ((address & 3) * 8)) & 0x000000FF;
+  }
+  void memWrite16(const uint32_t address, const uint16_t word) {
+    const uint32_t offset = (address & 1) * 16;
+    const uint32_t mask = 0xFFFF0000 >> offset;
+    record(address, true);
+    store(address, (load(address) & mask) | ((uint32_t)word << offset));
+  }
+  void memWrite8(const uint32_t address, const uint8_t b) {
+    const uint32_t offset = (address & 3) * 8;
+    const uint32_t mask = ~(0x000000FF << offset);
+    record(address, true);
+    store(address, (load(address) & mask) | ((uint32_t)b << offset));
+  }
+};
+
+/* firing interval of a timed transition */
+struct Interval_t {
+  int32_t eft, lft;
+};
+
+/*
+ * Cycles of the instructions of a core (--mcpu, as the -mcpu of gcc) beyond
+ * those of the hardware model, which executes an instruction in one cycle
+ * (T4) or in its bus accesses (T3): the firing interval of the transition of
+ * the instruction. The branches refill the pipeline, the conditional ones
+ * only when taken (_T), and the multiplications and divisions take the
+ * cycles of the multiplier and of the divider. The loads and stores, LDM
+ * and STM included, have no entry: their bus accesses (T3) give their time.
+ * The simulation delays the fetch of the instruction by the same cycles,
+ * which it needs exact; --zones and --static also take the intervals.
+ */
+struct CycleTable_t {
+  const char *cpu;
+  Interval_t mul;    // MULS, MUL
+  Interval_t div;    // SDIV
+  Interval_t branch; // B and taken B<cond>
+  Interval_t call;   // BL
+  Interval_t ret;    // BX lr, POP {..., pc}
+
+  /* every instruction has one number of cycles, as the simulation needs */
+  bool exact() const {
+    return mul.eft == mul.lft && div.eft == div.lft &&
+           branch.eft == branch.lft && call.eft == call.lft &&
+           ret.eft == ret.lft;
+  }
+};
+
+const CycleTable_t cycleTables[] = {
+    {"cortex-m0", {0, 0}, {0, 0}, {2, 2}, {3, 3}, {2, 2}},
+    {"cortex-m0plus", {0, 0}, {0, 0}, {1, 1}, {2, 2}, {1, 1}},
+    {"cortex-m0plus.small-multiply", {31, 31}, {0, 0}, {1, 1}, {2, 2}, {1, 1}},
+    {"cortex-m3", {0, 0}, {1, 11}, {1, 3}, {1, 3}, {1, 3}},
+    {"cortex-m4", {0, 0}, {1, 11}, {1, 3}, {1, 3}, {1, 3}},
+};
+
+const CycleTable_t *findCycleTable(const char *cpu) {
+  for (auto &table : cycleTables)
+    if (strcmp(table.cpu, cpu) == 0)
+      return &table;
+  return NULL;
+}
+
+/*
+ * Memory map of the bus accesses (--memory-map): an access takes the
+ * cycles of a bus access of the hardware model plus the wait states of its
+ * region. In a burst region, a word next to the previous access of the
+ * instruction in the region takes no wait state. The stack region holds the
+ * stack of the model, under the initial stack pointer.
+ */
+struct Region_t {
+  string name;
+  uint32_t start;
+  uint32_t end;
+  uint32_t waitStates;
+  bool burst;
+};
+
+struct MemoryMap_t {
+  uint32_t access; // cycles of a bus access without wait state
+  vector<Region_t> regions;
+  int32_t stackRegion; // -1 if none, the stack then takes no wait state
+
+  MemoryMap_t() : access(4), stackRegion(-1) {}
+};
+
+/*===========================================================================*/
+
 class Inst_t {
 protected:
   bool reachable;
   uint32_t addr;
   uint32_t mPlaceId;
   uint32_t mTransitionId;
-
-  void printReg(const uint8_t regNum) {
+  bool mAbstracted;
+  bool mKeepFlags;
+  const char *mFuncPrefix; // of the function, for the program of a core
+  bool mWide;              // 32 bit encoding
+  int16_t mSegment;        // memory segment of the data accesses, -1 if any
+  int16_t mAccessCycles;   // bus cycles of the data accesses, -1 if not known
+
+  void printReg(Buffer_t &out, const uint8_t regNum) {
     if (regNum < 13)
-      printf("r%d", regNum);
+      out << 'r' << regNum;
     else
       switch (regNum) {
       case 13:
-        printf("sp");
+        out << "sp";
         break;
       case 14:
-        printf("lr");
+        out << "lr";
         break;
       case 15:
-        printf("pc");
+        out << "pc";
       }
   }
 
 public:
   Inst_t(const uint32_t inAddr)
-      : reachable(false), addr(inAddr), mPlaceId(0), mTransitionId(0) {}
+      : reachable(false), addr(inAddr), mPlaceId(0), mTransitionId(0),
+        mAbstracted(false), mKeepFlags(true), mFuncPrefix(""), mWide(false), mSegment(-1),
+        mAccessCycles(-1) {}
   static Inst_t *decodeThumb(const uint32_t inAddr, const uint16_t inCode);
   static Inst_t *decodeARM32(const uint32_t inAddr, const uint32_t inCode);
 
@@ -55,6 +603,8 @@ public:
   bool isReachable() { return reachable; }
   uint32_t address() { return addr; }
   virtual const char *guard() { return ""; }
+  /* value of guard() for the status register sr */
+  virtual bool taken(const int32_t sr) { return false; }
   void setPlaceId(const uint32_t inPlaceId) { mPlaceId = inPlaceId; }
   uint32_t placeId() { return mPlaceId; }
   void setTransitionId(const uint32_t inTransitionId) {
@@ -69,36 +619,279 @@ public:
   virtual uint32_t branchAddress() { return 0; }
   virtual bool isFuncCall() { return false; }
   virtual bool isFuncReturn() { return false; }
-  virtual void romeoFuncContent() {};
+  virtual void romeoFuncContent(Buffer_t &out) {};
   virtual bool isLDRPC() { return false; }
   virtual uint32_t targetWord() { return 0; }
   virtual bool isCondBranch() { return false; }
+  virtual bool isMultiply() { return false; }
+  virtual bool isDivide() { return false; }
   virtual bool isUncondBranch() { return false; }
   virtual void setImmByPC(const uint32_t inImm) {}
-  virtual void Print() = 0;
+  virtual void Print(Buffer_t &out) = 0;
   virtual uint8_t memAccessCount() { return 0; }
-
-  void romeoFunc() {
-    printf("int inst%x(core_t &core, mem_t &mem) { // ", addr);
-    Print();
-    printf("\n");
-    romeoFuncContent();
-    printf("  return cacheAccess(core.ICache, %d);\n", addr);
-    printf("}\n\n");
+  /* registers read and written by the generated code (bit n is rn) */
+  virtual uint16_t readRegs() { return 0; }
+  virtual uint16_t writtenRegs() { return 0; }
+  virtual bool writesFlags() { return false; }
+  /* abstract execution of the generated code */
+  virtual void absExec(AbsState_t &s) {
+    const bool taint = s.regsTaint(readRegs());
+    s.writeRegs(writtenRegs(), AbsValue_t::top(taint));
+    if (writesFlags())
+      s.srTaint = taint;
+  }
+  /* concrete execution of the generated code, for the simulation */
+  virtual void exec(Machine_t &m) {}
+
+  /*
+   * Data abstraction. The generated code of an abstracted instruction does
+   * not update the state, and the status register is updated only if it
+   * is needed afterwards (see abstractData()).
+   */
+  void setAbstracted(const bool inAbstracted) { mAbstracted = inAbstracted; }
+  bool isAbstracted() { return mAbstracted; }
+  void setKeepFlags(const bool inKeepFlags) { mKeepFlags = inKeepFlags; }
+
+  /*
+   * Register slicing. Only the registers that are both read and written by
+   * the reachable program are kept in registers_t. A register that is only
+   * read keeps its initial value and is emitted as a constant, a register
+   * that is only written is never observed and its value is discarded.
+   */
+  static void setStateRegs(const uint16_t inStateRegs);
+  static uint8_t stateRegCount() { return sStateRegCount; }
+  static int8_t regSlot(const uint8_t reg) { return sRegSlot[reg]; }
+  static void regInitValue(Buffer_t &out, const uint8_t reg) {
+    if (reg == 13)
+      out << "(dataStart + 100)";
+    else
+      out << reg;
+  }
+
+  void setFuncPrefix(const char *inFuncPrefix) { mFuncPrefix = inFuncPrefix; }
+  const char *funcPrefix() { return mFuncPrefix; }
+  void setWide() { mWide = true; }
+
+  /*
+   * With a prefetch buffer, a fetch reads the whole word of the instruction
+   * from the cache and an instruction within the word read last is in the
+   * buffer: the function then returns 2 instead of the cache access. When
+   * the instruction falls through to the second half of the word it read,
+   * the next instruction is known to be in the buffer: the hardware model
+   * then executes the instruction and gives the next one to the program net
+   * at once (ExeBuffered, MemBuffered), without a fetch sequence.
+   */
+  static void setPrefetch(const bool inPrefetch) { sPrefetch = inPrefetch; }
+  static bool prefetch() { return sPrefetch; }
+  bool nextBuffered() {
+    return sPrefetch && !isCondBranch() && !isUncondBranch() &&
+           !isFuncCall() && !isFuncReturn() &&
+           (addr + (mWide ? 4 : 2)) % 4 == 2;
+  }
+  void fetch(Buffer_t &out) {
+    if (!sPrefetch) {
+      out << "  int hit = cacheAccess(core.ICache, " << addr << ");\n";
+      return;
+    }
+    const uint32_t first = addr >> 2;
+    const uint32_t last = (addr + (mWide ? 2 : 0)) >> 2;
+    if (first == last) {
+      out << "  int hit = 2; // in the prefetch buffer\n";
+      out << "  if (core.fetchBuffer != " << first << ") {\n";
+      out << "    hit = cacheAccess(core.ICache, " << addr << ");\n  }\n";
+    } else { // across two words, the second one is never in the buffer
+      out << "  int hit = cacheAccess(core.ICache, " << addr << ");\n";
+    }
+    out << "  core.fetchBuffer = " << last << ";\n";
+  }
+
+  /*
+   * With a memory shared by the cores, the functions also take the shared
+   * memory and the memory accesses choose between it and the memory of the
+   * core.
+   */
+  static void setSharedMem(const bool inShared) { sSharedMem = inShared; }
+  static bool sharedMem() { return sSharedMem; }
+  static const char *memArgs() { return sSharedMem ? "mem, shared," : "mem,"; }
+
+  /* cycles of the instruction beyond the hardware model, none by default */
+  static void setCycleTable(const CycleTable_t *inTable) {
+    sCycleTable = inTable;
+  }
+  Interval_t cycles(const bool taken) {
+    const Interval_t none = {0, 0};
+    if (sCycleTable == NULL)
+      return none;
+    if (isCondBranch())
+      return taken ? sCycleTable->branch : none;
+    if (isUncondBranch())
+      return sCycleTable->branch;
+    if (isFuncCall())
+      return sCycleTable->call;
+    if (isFuncReturn())
+      return sCycleTable->ret;
+    if (isMultiply())
+      return sCycleTable->mul;
+    if (isDivide())
+      return sCycleTable->div;
+    return none;
+  }
+  /* delay of the firing when executed from sr, with an exact cycle table */
+  uint32_t cyclesFrom(const int32_t sr) { return cycles(taken(sr)).eft; }
+
+  /*
+   * With a segmented memory, mem_t has one array per segment. When the
+   * data flow analysis shows that the data accesses of the instruction all
+   * go to one segment, they call the functions of the segment (suffixed by
+   * its name) and the address is not decoded by the model.
+   */
+  static void setSegmentNames(const vector<string> &inNames) {
+    sSegmentNames = inNames;
+  }
+  void setSegment(const int16_t inSegment) { mSegment = inSegment; }
+  const char *memSuffix() {
+    return mSegment < 0 ? "" : sSegmentNames[mSegment].c_str();
+  }
+
+  /*
+   * With a unified cache, the data accesses of the instruction go through
+   * the cache after its fetch. With a data cache, they go through the data
+   * cache of the core: a store writes through it (allocating the line) and
+   * always accesses the bus, a load only on a miss. The function then sets
+   * the access count of the instruction (ac) to its bus accesses.
+   * With a memory map, ac is the count of bus cycles of the accesses, set
+   * by the function: the cycles found by classifyAccesses(), or the sum of
+   * memCycles() of the addresses when they are not known.
+   */
+  static void setUnifiedCache(const bool inUnified) { sUnifiedCache = inUnified; }
+  static void setDataCache(const bool inDataCache) { sDataCache = inDataCache; }
+  static void setMemoryMap(const bool inMemoryMap) { sMemoryMap = inMemoryMap; }
+  static bool setsAccessCount() { return sDataCache || sMemoryMap; }
+  void setAccessCycles(const int16_t inCycles) { mAccessCycles = inCycles; }
+  static string funcArgs(const string &index) {
+    string args = "st[" + index + "],mem[" + index + "]";
+    if (sSharedMem)
+      args += ",shared";
+    if (setsAccessCount())
+      args += ",ac[" + index + "]";
+    return args;
+  }
+  bool beginDataAccess(Buffer_t &out, const bool write) {
+    if (sUnifiedCache)
+      out << "  cacheAccess(core.ICache, ";
+    else if (sDataCache)
+      out << (write ? "  dcacheAccess(core.DCache, "
+                    : "  hits = hits + dcacheAccess(core.DCache, ");
+    else if (sMemoryMap && mAccessCycles < 0)
+      out << "  cycles = cycles + memCycles(";
+    else
+      return false;
+    return true;
+  }
+  void dataAccess(Buffer_t &out, const uint8_t reg, const int32_t offset,
+                  const bool write) {
+    if (beginDataAccess(out, write)) {
+      pReg(out, reg);
+      if (offset < 0)
+        out << " - " << -offset << ");\n";
+      else
+        out << " + " << offset << ");\n";
+    }
+  }
+  void dataAccess(Buffer_t &out, const char *variable, const bool write) {
+    if (beginDataAccess(out, write))
+      out << variable << ");\n";
+  }
+  void dataAccess(Buffer_t &out, const uint32_t address, const bool write) {
+    if (beginDataAccess(out, write))
+      out << address << ");\n";
+  }
+
+  void romeoFunc(Buffer_t &out) {
+    const bool loads = sDataCache && !mAbstracted && memAccessCount() > 0;
+    const bool cycles = sMemoryMap && memAccessCount() > 0 && mAccessCycles < 0;
+    out << "int " << mFuncPrefix << "inst" << Hex_t(addr)
+        << "(core_t &core, mem_t &mem"
+        << (sSharedMem ? ", shared_t &shared" : "")
+        << (setsAccessCount() ? ", uint8_t &ac) { // " : ") { // ");
+    Print(out);
+    out << '\n';
+    if (sUnifiedCache || sPrefetch)
+      fetch(out);
+    if (loads)
+      out << "  int hits = 0;\n";
+    else if (cycles)
+      out << "  int cycles = 0;\n";
+    if (!mAbstracted) {
+      if (writtenRegs() & ~sStateRegs)
+        out << "  uint32_t discard = 0;\n";
+      romeoFuncContent(out);
+    }
+    if (loads)
+      out << "  ac = " << (int)memAccessCount() << " - hits;\n";
+    else if (sDataCache)
+      out << "  ac = " << (int)memAccessCount() << ";\n";
+    else if (cycles)
+      out << "  ac = cycles;\n";
+    else if (sMemoryMap)
+      out << "  ac = " << max<int>(mAccessCycles, 0) << ";\n";
+    if (sUnifiedCache || sPrefetch)
+      out << "  return hit;\n";
+    else
+      out << "  return cacheAccess(core.ICache, " << addr << ");\n";
+    out << "}\n\n";
+  }
+  void wReg(Buffer_t &out, uint8_t reg) {
+    if (sRegSlot[reg] < 0)
+      out << "  discard = ";
+    else
+      out << "  core.regs.r[" << sRegSlot[reg] << "] = ";
   }
-  void wReg(uint8_t reg) { printf("  core.regs.r[%d] = ", reg); }
-  void pReg(uint8_t reg) { printf("core.regs.r[%d]", reg); }
-  const char *pRegS(uint8_t reg) {
-    static char buf[40];
-    snprintf(buf, 40, "core.regs.r[%d]", reg);
-    return buf;
+  void pReg(Buffer_t &out, uint8_t reg) {
+    if (sRegSlot[reg] < 0)
+      regInitValue(out, reg);
+    else
+      out << "core.regs.r[" << sRegSlot[reg] << ']';
   }
 
-  void updateSR(const char *val, const char *op1, const char *op2) {
-    printf("  updateSR(core.regs, %s, %s, %s);\n", val, op1, op2);
+  /* operand of updateSR(), a variable of the generated code or a register */
+  struct Operand_t {
+    const char *name;
+    uint8_t reg;
+    Operand_t(const char *inName) : name(inName), reg(0) {}
+    Operand_t(const uint8_t inReg) : name(NULL), reg(inReg) {}
+  };
+  void operand(Buffer_t &out, const Operand_t &op) {
+    if (op.name != NULL)
+      out << op.name;
+    else
+      pReg(out, op.reg);
+  }
+  void updateSR(Buffer_t &out, const Operand_t &val, const Operand_t &op1,
+                const Operand_t &op2) {
+    if (mKeepFlags) {
+      out << "  updateSR(core.regs, ";
+      operand(out, val);
+      out << ", ";
+      operand(out, op1);
+      out << ", ";
+      operand(out, op2);
+      out << ");\n";
+    }
   }
 
 private:
+  static uint16_t sStateRegs;
+  static uint8_t sStateRegCount;
+  static bool sUnifiedCache;
+  static bool sDataCache;
+  static bool sMemoryMap;
+  static bool sPrefetch;
+  static bool sSharedMem;
+  static vector<string> sSegmentNames; // "_" followed by the name
+  static const CycleTable_t *sCycleTable;
+  static int8_t sRegSlot[16];
+
   static Inst_t *decodeThumb0(const uint32_t inAddr, const uint16_t inCode);
   static Inst_t *decodeThumb1(const uint32_t inAddr, const uint16_t inCode);
   static Inst_t *decodeThumb2(const uint32_t inAddr, const uint16_t inCode);
@@ -118,6 +911,29 @@ private:
                                       const uint16_t inCode);
 };
 
+uint16_t Inst_t::sStateRegs = 0xFFFF;
+uint8_t Inst_t::sStateRegCount = 16;
+bool Inst_t::sUnifiedCache = false;
+bool Inst_t::sDataCache = false;
+bool Inst_t::sMemoryMap = false;
+bool Inst_t::sPrefetch = false;
+bool Inst_t::sSharedMem = false;
+vector<string> Inst_t::sSegmentNames;
+const CycleTable_t *Inst_t::sCycleTable = NULL;
+int8_t Inst_t::sRegSlot[16] = {0, 1, 2,  3,  4,  5,  6,  7,
+                               8, 9, 10, 11, 12, 13, 14, 15};
+
+void Inst_t::setStateRegs(const uint16_t inStateRegs) {
+  sStateRegs = inStateRegs;
+  sStateRegCount = 0;
+  for (uint8_t reg = 0; reg < 16; reg++) {
+    if (inStateRegs & (1 << reg))
+      sRegSlot[reg] = sStateRegCount++;
+    else
+      sRegSlot[reg] = -1;
+  }
+}
+
 /*===========================================================================*/
 
 /* Decode 0 */
@@ -130,13 +946,26 @@ public:
     sReg = (inCode >> 3) & 0b111;
     dReg = inCode & 0b111;
   }
-  virtual void Print() { printf("%x: movs r%d, r%d", addr, dReg, sReg); }
-  virtual void romeoFuncContent() {
-    wReg(dReg);
-    pReg(sReg);
-    printf(";\n");
-    updateSR(pRegS(dReg), pRegS(sReg), pRegS(sReg));
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": movs r" << dReg << ", r" << sReg;
+  }
+  virtual uint16_t readRegs() { return 1 << sReg; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual bool writesFlags() { return true; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[dReg] = s.r[sReg];
+    s.srTaint = s.r[dReg].taint;
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    wReg(out, dReg);
+    pReg(out, sReg);
+    out << ";\n";
+    updateSR(out, dReg, sReg, sReg);
   };
+  virtual void exec(Machine_t &m) {
+    m.r[dReg] = m.r[sReg];
+    m.updateSR(m.r[dReg], m.r[sReg], m.r[sReg]);
+  }
 };
 
 class LSL_t : public Inst_t {
@@ -148,15 +977,20 @@ public:
     dReg = inCode & 0b111;
     imm5 = (inCode >> 6) & 0b11111;
   }
-  virtual void Print() {
-    printf("%x: lsl r%d, r%d, #%d", addr, dReg, sReg, imm5);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": lsl r" << dReg << ", r" << sReg << ", #" << imm5;
   }
-  virtual void romeoFuncContent() {
-    wReg(dReg);
-    pReg(sReg);
-    printf(" << %d;\n", imm5);
+  virtual uint16_t readRegs() { return 1 << sReg; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    wReg(out, dReg);
+    pReg(out, sReg);
+    out << " << " << imm5 << ";\n";
     //    updateSR(dReg);
   };
+  virtual void exec(Machine_t &m) {
+    m.r[dReg] = (uint32_t)m.r[sReg] << imm5;
+  }
 };
 
 class LSR_t : public Inst_t {
@@ -168,15 +1002,20 @@ public:
     dReg = inCode & 0b111;
     imm5 = (inCode >> 6) & 0b11111;
   }
-  virtual void Print() {
-    printf("%x: lsr r%d, r%d, #%d", addr, dReg, sReg, imm5);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": lsr r" << dReg << ", r" << sReg << ", #" << imm5;
   }
-  virtual void romeoFuncContent() {
-    wReg(dReg);
-    pReg(sReg);
-    printf(" >> %d;\n", imm5);
+  virtual uint16_t readRegs() { return 1 << sReg; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    wReg(out, dReg);
+    pReg(out, sReg);
+    out << " >> " << imm5 << ";\n";
     //    updateSR(dReg);
   };
+  virtual void exec(Machine_t &m) {
+    m.r[dReg] = m.r[sReg] >> imm5;
+  }
 };
 
 class ASR_t : public Inst_t {
@@ -188,15 +1027,20 @@ public:
     dReg = inCode & 0b111;
     imm5 = (inCode >> 6) & 0b11111;
   }
-  virtual void Print() {
-    printf("%x: asr r%d, r%d, #%d", addr, dReg, sReg, imm5);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": asr r" << dReg << ", r" << sReg << ", #" << imm5;
   }
-  virtual void romeoFuncContent() {
-    wReg(dReg);
-    pReg(sReg);
-    printf(" >> %d;\n", imm5);
+  virtual uint16_t readRegs() { return 1 << sReg; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    wReg(out, dReg);
+    pReg(out, sReg);
+    out << " >> " << imm5 << ";\n";
     //    updateSR(dReg);
   };
+  virtual void exec(Machine_t &m) {
+    m.r[dReg] = m.r[sReg] >> imm5;
+  }
 };
 
 class SUBR_t : public Inst_t {
@@ -208,8 +1052,8 @@ public:
     dReg = inCode & 0b111;
     mReg = (inCode >> 6) & 0b111;
   }
-  virtual void Print() {
-    printf("%x: sub r%d, r%d, r%d", addr, dReg, nReg, mReg);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": sub r" << dReg << ", r" << nReg << ", r" << mReg;
   }
 };
 
@@ -223,17 +1067,25 @@ public:
     mReg = (inCode >> 6) & 0b111;
   }
 
-  virtual void Print() {
-    printf("%x: add r%d, r%d, r%d", addr, dReg, nReg, mReg);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": add r" << dReg << ", r" << nReg << ", r" << mReg;
   }
 
-  virtual void romeoFuncContent() {
-    wReg(dReg);
-    pReg(nReg);
-    printf(" + ");
-    pReg(mReg);
-    printf(";\n");
+  virtual uint16_t readRegs() { return (1 << nReg) | (1 << mReg); }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[dReg] = s.r[nReg].plus(s.r[mReg]);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    wReg(out, dReg);
+    pReg(out, nReg);
+    out << " + ";
+    pReg(out, mReg);
+    out << ";\n";
   };
+  virtual void exec(Machine_t &m) {
+    m.r[dReg] = (uint32_t)m.r[nReg] + (uint32_t)m.r[mReg];
+  }
 };
 
 Inst_t *Inst_t::decodeThumb0(const uint32_t inAddr, const uint16_t inCode) {
@@ -274,13 +1126,26 @@ public:
     dReg = (inCode >> 8) & 0b111;
     imm8 = inCode & 0b11111111;
   }
-  virtual void Print() { printf("%x: movs r%d, #%d", addr, dReg, imm8); }
-  virtual void romeoFuncContent() {
-    printf("  uint32_t op = %d;\n", imm8);
-    wReg(dReg);
-    printf("op;\n");
-    updateSR(pRegS(dReg), "op", "op");
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": movs r" << dReg << ", #" << imm8;
+  }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual bool writesFlags() { return true; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[dReg] = AbsValue_t::constant(imm8);
+    s.srTaint = false;
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint32_t op = " << imm8 << ";\n";
+    wReg(out, dReg);
+    out << "op;\n";
+    updateSR(out, dReg, "op", "op");
   };
+  virtual void exec(Machine_t &m) {
+    const uint32_t op = imm8;
+    m.r[dReg] = op;
+    m.updateSR(m.r[dReg], op, op);
+  }
 };
 
 class CMP_t : public Inst_t {
@@ -292,15 +1157,24 @@ public:
     imm8 = inCode & 0b11111111;
   }
 
-  virtual void Print() { printf("%x: cmp r%d, #%d", addr, dReg, imm8); }
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": cmp r" << dReg << ", #" << imm8;
+  }
 
-  virtual void romeoFuncContent() {
-    printf("  uint64_t op1 = ");
-    pReg(dReg);
-    printf(";\n  uint64_t op2 = %d;\n", imm8);
-    printf("  uint64_t val = op1 - op2;\n");
-    updateSR("val", "op1", "-op2");
+  virtual uint16_t readRegs() { return 1 << dReg; }
+  virtual bool writesFlags() { return true; }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = ";
+    pReg(out, dReg);
+    out << ";\n  uint64_t op2 = " << imm8 << ";\n";
+    out << "  uint64_t val = op1 - op2;\n";
+    updateSR(out, "val", "op1", "-op2");
   };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = m.r[dReg];
+    const uint64_t op2 = imm8;
+    m.updateSR(op1 - op2, op1, -op2);
+  }
 };
 
 class ADD_t : public Inst_t {
@@ -311,17 +1185,33 @@ public:
     dReg = (inCode >> 8) & 0b111;
     imm8 = inCode & 0b11111111;
   }
-  virtual void Print() { printf("%x: adds r%d, #%d", addr, dReg, imm8); }
-
-  virtual void romeoFuncContent() {
-    printf("  uint64_t op1 = ");
-    pReg(dReg);
-    printf(";\n  uint64_t op2 = %d;\n", imm8);
-    printf("  uint64_t val = op1 + op2;\n");
-    wReg(dReg);
-    printf("val;\n");
-    updateSR("val", "op1", "op2");
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": adds r" << dReg << ", #" << imm8;
+  }
+
+  virtual uint16_t readRegs() { return 1 << dReg; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual bool writesFlags() { return true; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[dReg] = s.r[dReg].plus(imm8);
+    s.srTaint = s.r[dReg].taint;
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = ";
+    pReg(out, dReg);
+    out << ";\n  uint64_t op2 = " << imm8 << ";\n";
+    out << "  uint64_t val = op1 + op2;\n";
+    wReg(out, dReg);
+    out << "val;\n";
+    updateSR(out, "val", "op1", "op2");
   };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = m.r[dReg];
+    const uint64_t op2 = imm8;
+    const uint64_t val = op1 + op2;
+    m.r[dReg] = val;
+    m.updateSR(val, op1, op2);
+  }
 };
 
 class SUB_t : public Inst_t {
@@ -333,17 +1223,33 @@ public:
     imm8 = inCode & 0b11111111;
   }
 
-  virtual void Print() { printf("%x: subs r%d, #%d", addr, dReg, imm8); }
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": subs r" << dReg << ", #" << imm8;
+  }
 
-  virtual void romeoFuncContent() {
-    printf("  uint64_t op1 = ");
-    pReg(dReg);
-    printf(";\n  uint64_t op2 = %d;\n", imm8);
-    printf("  uint64_t val = op1 - op2;\n");
-    wReg(dReg);
-    printf("val;\n");
-    updateSR("val", "op1", "-op2");
+  virtual uint16_t readRegs() { return 1 << dReg; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual bool writesFlags() { return true; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[dReg] = s.r[dReg].plus(-imm8);
+    s.srTaint = s.r[dReg].taint;
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = ";
+    pReg(out, dReg);
+    out << ";\n  uint64_t op2 = " << imm8 << ";\n";
+    out << "  uint64_t val = op1 - op2;\n";
+    wReg(out, dReg);
+    out << "val;\n";
+    updateSR(out, "val", "op1", "-op2");
   };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = m.r[dReg];
+    const uint64_t op2 = imm8;
+    const uint64_t val = op1 - op2;
+    m.r[dReg] = val;
+    m.updateSR(val, op1, -op2);
+  }
 };
 
 Inst_t *Inst_t::decodeThumb1(const uint32_t inAddr, const uint16_t inCode) {
@@ -385,14 +1291,23 @@ public:
     const uint32_t pcAl = pc % 4 == 0 ? pc : (pc / 4 + 1) * 4;
     return pcAl + imm8 * 4;
   }
-  virtual void Print() {
-    printf("%x: ldr r%d, [pc, #%d]", addr, dReg, imm8 << 2);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": ldr r" << dReg << ", [pc, #" << (imm8 << 2) << "]";
   }
   virtual void setImmByPC(const uint32_t inImm) { immByPC = inImm; }
   virtual uint8_t memAccessCount() { return 1; }
-  virtual void romeoFuncContent() {
-    wReg(dReg);
-    printf("%d;\n", immByPC);
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[dReg] = AbsValue_t::constant(immByPC);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    dataAccess(out, targetWord(), false);
+    wReg(out, dReg);
+    out << (int32_t)immByPC << ";\n";
+  }
+  virtual void exec(Machine_t &m) {
+    m.record(targetWord(), false);
+    m.r[dReg] = immByPC;
   }
 };
 
@@ -404,17 +1319,29 @@ public:
     dReg = inCode & 0b111;
     sReg = (inCode >> 3) & 0b111;
   }
-  virtual void Print() { printf("%x: ands r%d, r%d", addr, dReg, sReg); }
-  virtual void romeoFuncContent() {
-    printf("  uint64_t op1 = ");
-    pReg(dReg);
-    printf(";\n  uint64_t op2 = ");
-    pReg(sReg);
-    printf(";\n  uint64_t val = op1 & op2;\n");
-    wReg(dReg);
-    printf("val;\n");
-    updateSR("val", "op1", "op2");
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": ands r" << dReg << ", r" << sReg;
+  }
+  virtual uint16_t readRegs() { return (1 << dReg) | (1 << sReg); }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual bool writesFlags() { return true; }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = ";
+    pReg(out, dReg);
+    out << ";\n  uint64_t op2 = ";
+    pReg(out, sReg);
+    out << ";\n  uint64_t val = op1 & op2;\n";
+    wReg(out, dReg);
+    out << "val;\n";
+    updateSR(out, "val", "op1", "op2");
   };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = m.r[dReg];
+    const uint64_t op2 = m.r[sReg];
+    const uint64_t val = op1 & op2;
+    m.r[dReg] = val;
+    m.updateSR(val, op1, op2);
+  }
 };
 
 class ADC_t : public Inst_t {
@@ -425,18 +1352,30 @@ public:
     dReg = inCode & 0b111;
     sReg = (inCode >> 3) & 0b111;
   }
-  virtual void Print() { printf("%x: adcs r%d, r%d", addr, dReg, sReg); }
-
-  virtual void romeoFuncContent() {
-    printf("  uint64_t op1 = ");
-    pReg(dReg);
-    printf(";\n  uint64_t op2 = ");
-    pReg(dReg);
-    printf(";\n  uint64_t val = op1 + op2;\n");
-    wReg(dReg);
-    printf("val;\n");
-    updateSR("val", "op1", "op2");
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": adcs r" << dReg << ", r" << sReg;
+  }
+
+  virtual uint16_t readRegs() { return 1 << dReg; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual bool writesFlags() { return true; }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = ";
+    pReg(out, dReg);
+    out << ";\n  uint64_t op2 = ";
+    pReg(out, dReg);
+    out << ";\n  uint64_t val = op1 + op2;\n";
+    wReg(out, dReg);
+    out << "val;\n";
+    updateSR(out, "val", "op1", "op2");
   };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = m.r[dReg];
+    const uint64_t op2 = m.r[dReg];
+    const uint64_t val = op1 + op2;
+    m.r[dReg] = val;
+    m.updateSR(val, op1, op2);
+  }
 };
 
 class RSB_t : public Inst_t {
@@ -447,16 +1386,28 @@ public:
     dReg = inCode & 0b111;
     sReg = (inCode >> 3) & 0b111;
   }
-  virtual void Print() { printf("%x: negs r%d, r%d", addr, dReg, sReg); }
-  virtual void romeoFuncContent() {
-    printf("  uint64_t op1 = 0;\n");
-    printf("  uint64_t op2 = ");
-    pReg(sReg);
-    printf(";\n  uint64_t val = op1 - op2;\n");
-    wReg(dReg);
-    printf("val;\n");
-    updateSR("val", "op1", "-op2");
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": negs r" << dReg << ", r" << sReg;
+  }
+  virtual uint16_t readRegs() { return 1 << sReg; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual bool writesFlags() { return true; }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = 0;\n";
+    out << "  uint64_t op2 = ";
+    pReg(out, sReg);
+    out << ";\n  uint64_t val = op1 - op2;\n";
+    wReg(out, dReg);
+    out << "val;\n";
+    updateSR(out, "val", "op1", "-op2");
   };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = 0;
+    const uint64_t op2 = m.r[sReg];
+    const uint64_t val = op1 - op2;
+    m.r[dReg] = val;
+    m.updateSR(val, op1, -op2);
+  }
 };
 
 class CMPR_t : public Inst_t {
@@ -468,16 +1419,25 @@ public:
     sReg = (inCode >> 3) & 0b111;
   }
 
-  virtual void Print() { printf("%x: cmp r%d, r%d", addr, dReg, sReg); }
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": cmp r" << dReg << ", r" << sReg;
+  }
 
-  virtual void romeoFuncContent() {
-    printf("  uint64_t op1 = ");
-    pReg(dReg);
-    printf(";\n  uint64_t op2 = ");
-    pReg(sReg);
-    printf(";\n  uint64_t val = op1 - op2;\n");
-    updateSR("val", "op1", "-op2");
+  virtual uint16_t readRegs() { return (1 << dReg) | (1 << sReg); }
+  virtual bool writesFlags() { return true; }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = ";
+    pReg(out, dReg);
+    out << ";\n  uint64_t op2 = ";
+    pReg(out, sReg);
+    out << ";\n  uint64_t val = op1 - op2;\n";
+    updateSR(out, "val", "op1", "-op2");
   };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = m.r[dReg];
+    const uint64_t op2 = m.r[sReg];
+    m.updateSR(op1 - op2, op1, -op2);
+  }
 };
 
 class BX_t : public Inst_t {
@@ -489,9 +1449,9 @@ public:
       : Inst_t(inAddr), targetId(0) {
     reg = (inCode >> 3) & 0b1111;
   }
-  virtual void Print() {
-    printf("%x: bx ", addr);
-    printReg(reg);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": bx ";
+    printReg(out, reg);
   }
   virtual void setTargetIdTaken(const uint32_t inTargetId) {
     targetId = inTargetId;
@@ -507,9 +1467,9 @@ public:
   BLX_t(const uint32_t inAddr, const uint16_t inCode) : Inst_t(inAddr) {
     reg = (inCode >> 3) & 0b1111;
   }
-  virtual void Print() {
-    printf("%x: blx ", addr);
-    printReg(reg);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": blx ";
+    printReg(out, reg);
   }
 };
 
@@ -522,22 +1482,36 @@ public:
     dReg = ((inCode >> 4) & 0b1000) | (inCode & 0b111); // DN:Rdn
     sReg = (inCode >> 3) & 0b1111;                      // Rm
   }
-  virtual void Print() {
-    printf("%x: add ", addr);
-    printReg(Rdn);
-    printf(", ");
-    printReg(sReg);
-  }
-  virtual void romeoFuncContent() {
-    printf("  uint64_t op1 = ");
-    pReg(dReg);
-    printf(";\n  uint64_t op2 = ");
-    pReg(sReg);
-    printf(";\n  uint64_t val = op1 + op2;\n");
-    wReg(dReg);
-    printf("val;\n");
-    updateSR("val", "op1", "op2");
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": add ";
+    printReg(out, Rdn);
+    out << ", ";
+    printReg(out, sReg);
+  }
+  virtual uint16_t readRegs() { return (1 << dReg) | (1 << sReg); }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual bool writesFlags() { return true; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[dReg] = s.r[dReg].plus(s.r[sReg]);
+    s.srTaint = s.r[dReg].taint;
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = ";
+    pReg(out, dReg);
+    out << ";\n  uint64_t op2 = ";
+    pReg(out, sReg);
+    out << ";\n  uint64_t val = op1 + op2;\n";
+    wReg(out, dReg);
+    out << "val;\n";
+    updateSR(out, "val", "op1", "op2");
   };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = m.r[dReg];
+    const uint64_t op2 = m.r[sReg];
+    const uint64_t val = op1 + op2;
+    m.r[dReg] = val;
+    m.updateSR(val, op1, op2);
+  }
 };
 
 class SDPMOV_t : public Inst_t {
@@ -548,19 +1522,63 @@ public:
     dReg = ((inCode >> 4) & 0b1000) | (inCode & 0b111);
     sReg = (inCode >> 3) & 0b1111;
   }
-  virtual void Print() {
-    printf("%x: mov ", addr);
-    printReg(dReg);
-    printf(", ");
-    printReg(sReg);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": mov ";
+    printReg(out, dReg);
+    out << ", ";
+    printReg(out, sReg);
+  }
+  virtual uint16_t readRegs() { return dReg != sReg ? (1 << sReg) : 0; }
+  virtual uint16_t writtenRegs() { return dReg != sReg ? (1 << dReg) : 0; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[dReg] = s.r[sReg];
   }
-  virtual void romeoFuncContent() {
+  virtual void romeoFuncContent(Buffer_t &out) {
     if (dReg != sReg) {
-      wReg(dReg);
-      pReg(sReg);
-      printf(";\n");
+      wReg(out, dReg);
+      pReg(out, sReg);
+      out << ";\n";
     }
   };
+  virtual void exec(Machine_t &m) {
+    if (dReg != sReg)
+      m.r[dReg] = m.r[sReg];
+  }
+};
+
+class MULS_t : public Inst_t {
+  uint8_t dReg, sReg;
+
+public:
+  MULS_t(const uint32_t inAddr, const uint16_t inCode) : Inst_t(inAddr) {
+    dReg = inCode & 0b111;
+    sReg = (inCode >> 3) & 0b111;
+  }
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": muls r" << dReg << ", r" << sReg << ", r"
+        << dReg;
+  }
+  virtual bool isMultiply() { return true; }
+  virtual uint16_t readRegs() { return (1 << dReg) | (1 << sReg); }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual bool writesFlags() { return true; }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = ";
+    pReg(out, sReg);
+    out << ";\n  uint64_t op2 = ";
+    pReg(out, dReg);
+    out << ";\n  uint64_t val = op1 * op2;\n";
+    wReg(out, dReg);
+    out << "val;\n";
+    updateSR(out, "val", "op1", "op2");
+  };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = m.r[sReg];
+    const uint64_t op2 = m.r[dReg];
+    const uint64_t val = op1 * op2;
+    m.r[dReg] = val;
+    m.updateSR(val, op1, op2);
+  }
 };
 
 Inst_t *Inst_t::decodeThumb2(const uint32_t inAddr, const uint16_t inCode) {
@@ -602,6 +1620,8 @@ Inst_t *Inst_t::decodeThumb2(const uint32_t inAddr, const uint16_t inCode) {
         break;
       case 10:
         return new CMPR_t(inAddr, inCode);
+      case 13:
+        return new MULS_t(inAddr, inCode);
       default:
         printf("Unsupported data processing inst: %d\n", secondOpCode);
         printf("Instruction %x @ |0x%.8x|", inCode, inAddr);
@@ -633,7 +1653,9 @@ public:
     imm8 = inCode & 0b11111111;
     dReg = (inCode >> 8) & 0b111;
   }
-  virtual void Print() { printf("%x: adr r%d, pc, #%d", addr, dReg, imm8); }
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": adr r" << dReg << ", pc, #" << imm8;
+  }
 };
 
 class ADDTOSP_t : public Inst_t {
@@ -645,13 +1667,23 @@ public:
     dReg = (inCode >> 8) & 0b111;
   }
 
-  virtual void Print() { printf("%x: add r%d, sp, #%d", addr, dReg, imm8); }
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": add r" << dReg << ", sp, #" << imm8;
+  }
 
-  virtual void romeoFuncContent() {
-    wReg(dReg);
-    pReg(13);
-    printf(" + %d;\n", imm8);
+  virtual uint16_t readRegs() { return 1 << 13; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[dReg] = s.r[13].plus(imm8);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    wReg(out, dReg);
+    pReg(out, 13);
+    out << " + " << imm8 << ";\n";
   };
+  virtual void exec(Machine_t &m) {
+    m.r[dReg] = (uint32_t)m.r[13] + imm8;
+  }
 };
 
 class SUBSP_t : public Inst_t {
@@ -661,17 +1693,33 @@ public:
   SUBSP_t(const uint32_t inAddr, const uint16_t inCode) : Inst_t(inAddr) {
     imm7 = (inCode & 0b1111111) << 2;
   }
-  virtual void Print() { printf("%x: sub sp, #%d", addr, imm7); }
-
-  virtual void romeoFuncContent() {
-    printf("  uint64_t op1 = ");
-    pReg(13);
-    printf(";\n  uint64_t op2 = %d;\n", imm7);
-    printf("  uint64_t val = op1 - op2;\n");
-    wReg(13);
-    printf("val;\n");
-    updateSR("val", "op1", "-op2");
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": sub sp, #" << imm7;
+  }
+
+  virtual uint16_t readRegs() { return 1 << 13; }
+  virtual uint16_t writtenRegs() { return 1 << 13; }
+  virtual bool writesFlags() { return true; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[13] = s.r[13].plus(-imm7);
+    s.srTaint = s.r[13].taint;
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = ";
+    pReg(out, 13);
+    out << ";\n  uint64_t op2 = " << imm7 << ";\n";
+    out << "  uint64_t val = op1 - op2;\n";
+    wReg(out, 13);
+    out << "val;\n";
+    updateSR(out, "val", "op1", "-op2");
   };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = m.r[13];
+    const uint64_t op2 = imm7;
+    const uint64_t val = op1 - op2;
+    m.r[13] = val;
+    m.updateSR(val, op1, -op2);
+  }
 };
 
 class ADDSP_t : public Inst_t {
@@ -681,17 +1729,33 @@ public:
   ADDSP_t(const uint32_t inAddr, const uint16_t inCode) : Inst_t(inAddr) {
     imm7 = (inCode & 0b1111111) << 2;
   }
-  virtual void Print() { printf("%x: add sp, #%d", addr, imm7); }
-
-  virtual void romeoFuncContent() {
-    printf("  uint64_t op1 = ");
-    pReg(13);
-    printf(";\n  uint64_t op2 = %d;\n", imm7);
-    printf("  uint64_t val = op1 + op2;\n");
-    wReg(13);
-    printf("val;\n");
-    updateSR("val", "op1", "op2");
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": add sp, #" << imm7;
+  }
+
+  virtual uint16_t readRegs() { return 1 << 13; }
+  virtual uint16_t writtenRegs() { return 1 << 13; }
+  virtual bool writesFlags() { return true; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[13] = s.r[13].plus(imm7);
+    s.srTaint = s.r[13].taint;
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = ";
+    pReg(out, 13);
+    out << ";\n  uint64_t op2 = " << imm7 << ";\n";
+    out << "  uint64_t val = op1 + op2;\n";
+    wReg(out, 13);
+    out << "val;\n";
+    updateSR(out, "val", "op1", "op2");
   };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = m.r[13];
+    const uint64_t op2 = imm7;
+    const uint64_t val = op1 + op2;
+    m.r[13] = val;
+    m.updateSR(val, op1, op2);
+  }
 };
 
 class PUSHLIST_t : public Inst_t {
@@ -701,8 +1765,8 @@ public:
   PUSHLIST_t(const uint32_t inAddr, const uint16_t inCode) : Inst_t(inAddr) {
     sRegList = (inCode & 0b11111111) | ((inCode & 0b100000000) << 6);
   }
-  virtual void Print() {
-    printf("%x: push {", addr);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": push {";
     uint16_t rn = 0, rl = sRegList;
     bool first = true;
     while (rl != 0) {
@@ -710,13 +1774,13 @@ public:
         if (first)
           first = false;
         else
-          printf(", ");
-        printReg(rn);
+          out << ", ";
+        printReg(out, rn);
       }
       rl >>= 1;
       rn++;
     }
-    printf("}");
+    out << "}";
   }
 
   virtual uint8_t memAccessCount() {
@@ -730,26 +1794,57 @@ public:
     return accessCount;
   }
 
-  virtual void romeoFuncContent() {
+  virtual uint16_t readRegs() { return (1 << 13) | sRegList; }
+  virtual uint16_t writtenRegs() { return 1 << 13; }
+  virtual void absExec(AbsState_t &s) {
+    uint16_t regList = sRegList;
+    uint8_t regNum = 0;
+    int32_t regCount = 0;
+    while (regList != 0) {
+      if (regList & 1) {
+        regCount++;
+        s.store(s.r[13].plus(-regCount * 4), s.r[regNum], true);
+      }
+      regList >>= 1;
+      regNum++;
+    }
+    s.r[13] = s.r[13].plus(-regCount * 4);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
     uint16_t regList = sRegList;
     uint8_t regNum = 0;
     uint8_t regCount = 0;
     while (regList != 0) {
       if (regList & 1) {
         regCount++;
-        printf("  memWrite(mem, ");
-        pReg(13);
-        printf(" - %d, ", regCount * 4);
-        pReg(regNum);
-        printf(");\n");
+        dataAccess(out, 13, -regCount * 4, true);
+        out << "  memWrite" << memSuffix() << "(" << memArgs() << " ";
+        pReg(out, 13);
+        out << " - " << (regCount * 4) << ", ";
+        pReg(out, regNum);
+        out << ");\n";
       }
       regList >>= 1;
       regNum++;
     }
-    wReg(13);
-    pReg(13);
-    printf(" - %d;\n", regCount * 4);
+    wReg(out, 13);
+    pReg(out, 13);
+    out << " - " << (regCount * 4) << ";\n";
   };
+  virtual void exec(Machine_t &m) {
+    uint16_t regList = sRegList;
+    uint8_t regNum = 0;
+    uint8_t regCount = 0;
+    while (regList != 0) {
+      if (regList & 1) {
+        regCount++;
+        m.memWrite(m.r[13] - regCount * 4, m.r[regNum]);
+      }
+      regList >>= 1;
+      regNum++;
+    }
+    m.r[13] = (uint32_t)m.r[13] - regCount * 4;
+  }
 };
 
 class POPLIST_t : public Inst_t {
@@ -761,8 +1856,8 @@ public:
       : Inst_t(inAddr), mTargetIdTaken(0) {
     dRegList = (inCode & 0b11111111) | ((inCode & 0b100000000) << 7);
   }
-  virtual void Print() {
-    printf("%x: pop {", addr);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": pop {";
     uint16_t rn = 0, rl = dRegList;
     bool first = true;
     while (rl != 0) {
@@ -770,13 +1865,13 @@ public:
         if (first)
           first = false;
         else
-          printf(", ");
-        printReg(rn);
+          out << ", ";
+        printReg(out, rn);
       }
       rl >>= 1;
       rn++;
     }
-    printf("}");
+    out << "}";
   }
 
   virtual uint8_t memAccessCount() {
@@ -790,25 +1885,56 @@ public:
     return accessCount;
   }
 
-  virtual void romeoFuncContent() {
+  virtual uint16_t readRegs() { return 1 << 13; }
+  virtual uint16_t writtenRegs() { return (1 << 13) | dRegList; }
+  virtual void absExec(AbsState_t &s) {
+    uint16_t regList = dRegList;
+    uint8_t regNum = 15;
+    int32_t regCount = 0;
+    while (regList != 0) {
+      if (regList & (1 << 15)) {
+        s.r[regNum] = s.load(s.r[13].plus(regCount * 4), true);
+        regCount++;
+      }
+      regList <<= 1;
+      regNum--;
+    }
+    s.r[13] = s.r[13].plus(regCount * 4);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
     uint16_t regList = dRegList;
     uint8_t regNum = 15;
     uint8_t regCount = 0;
     while (regList != 0) {
       if (regList & (1 << 15)) {
-        wReg(regNum);
-        printf("memRead(mem, ");
-        pReg(13);
-        printf(" + %d);\n", regCount * 4);
+        dataAccess(out, 13, regCount * 4, false);
+        wReg(out, regNum);
+        out << "memRead" << memSuffix() << "(" << memArgs() << " ";
+        pReg(out, 13);
+        out << " + " << (regCount * 4) << ");\n";
         regCount++;
       }
       regList <<= 1;
       regNum--;
     }
-    wReg(13);
-    pReg(13);
-    printf(" + %d;\n", regCount * 4);
+    wReg(out, 13);
+    pReg(out, 13);
+    out << " + " << (regCount * 4) << ";\n";
   };
+  virtual void exec(Machine_t &m) {
+    uint16_t regList = dRegList;
+    uint8_t regNum = 15;
+    uint8_t regCount = 0;
+    while (regList != 0) {
+      if (regList & (1 << 15)) {
+        m.r[regNum] = m.memRead(m.r[13] + regCount * 4);
+        regCount++;
+      }
+      regList <<= 1;
+      regNum--;
+    }
+    m.r[13] = (uint32_t)m.r[13] + regCount * 4;
+  }
   virtual bool isFuncReturn() { return (dRegList & (1 << 15)) != 0; }
   virtual void setTargetIdTaken(const uint32_t inTargetId) {
     if ((dRegList & (1 << 15)) != 0)
@@ -826,9 +1952,9 @@ class NOP_t : public Inst_t {
 
 public:
   NOP_t(const uint32_t inAddr, const uint16_t inCode) : Inst_t(inAddr) {}
-  virtual void Print() { printf("%x: nop", addr); }
+  virtual void Print(Buffer_t &out) { out << Hex_t(addr) << ": nop"; }
 
-  /*virtual void romeoFuncContent() {
+  /*virtual void romeoFuncContent(Buffer_t &out) {
   };*/
 };
 
@@ -840,14 +1966,21 @@ public:
     dReg = inCode & 0b111;
     sReg = (inCode >> 3) & 0b111;
   }
-  virtual void Print() { printf("%x: uxtb r%d, r%d", addr, dReg, sReg); }
-  virtual void romeoFuncContent() {
-    printf("  uint32_t op = ");
-    pReg(sReg);
-    printf(";\n  op = op & 0x000000FF;\n");
-    wReg(dReg);
-    printf("op;\n");
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": uxtb r" << dReg << ", r" << sReg;
+  }
+  virtual uint16_t readRegs() { return 1 << sReg; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint32_t op = ";
+    pReg(out, sReg);
+    out << ";\n  op = op & 0x000000FF;\n";
+    wReg(out, dReg);
+    out << "op;\n";
   };
+  virtual void exec(Machine_t &m) {
+    m.r[dReg] = m.r[sReg] & 0x000000FF;
+  }
 };
 
 Inst_t *Inst_t::decodeSignExtentInst(const uint32_t inAddr,
@@ -930,18 +2063,27 @@ public:
     iReg = (inCode >> 3) & 0b111;
   }
 
-  virtual void Print() {
-    printf("%x: str.w r%d, [r%d, #%d]", addr, sReg, iReg, imm5 << 2);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": str.w r" << sReg << ", [r" << iReg << ", #"
+        << (imm5 << 2) << "]";
   }
 
   virtual uint8_t memAccessCount() { return 1; }
 
-  virtual void romeoFuncContent() {
-    printf("  memWrite(mem, ");
-    pReg(iReg);
-    printf(" + %d, ", imm5 << 2);
-    pReg(sReg);
-    printf(");\n");
+  virtual uint16_t readRegs() { return (1 << iReg) | (1 << sReg); }
+  virtual void absExec(AbsState_t &s) {
+    s.store(s.r[iReg].plus(imm5 << 2), s.r[sReg], true);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    dataAccess(out, iReg, imm5 << 2, true);
+    out << "  memWrite" << memSuffix() << "(" << memArgs() << " ";
+    pReg(out, iReg);
+    out << " + " << (imm5 << 2) << ", ";
+    pReg(out, sReg);
+    out << ");\n";
+  }
+  virtual void exec(Machine_t &m) {
+    m.memWrite(m.r[iReg] + (imm5 << 2), m.r[sReg]);
   }
 };
 
@@ -955,17 +2097,27 @@ public:
     iReg = (inCode >> 3) & 0b111;
   }
 
-  virtual void Print() {
-    printf("%x: ldr.w r%d, [r%d, #%d]", addr, dReg, iReg, imm5 << 2);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": ldr.w r" << dReg << ", [r" << iReg << ", #"
+        << (imm5 << 2) << "]";
   }
 
   virtual uint8_t memAccessCount() { return 1; }
 
-  virtual void romeoFuncContent() {
-    wReg(dReg);
-    printf("memRead(mem, ");
-    pReg(iReg);
-    printf(" + %d);\n", imm5 << 2);
+  virtual uint16_t readRegs() { return 1 << iReg; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[dReg] = s.load(s.r[iReg].plus(imm5 << 2), true);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    dataAccess(out, iReg, imm5 << 2, false);
+    wReg(out, dReg);
+    out << "memRead" << memSuffix() << "(" << memArgs() << " ";
+    pReg(out, iReg);
+    out << " + " << (imm5 << 2) << ");\n";
+  }
+  virtual void exec(Machine_t &m) {
+    m.r[dReg] = m.memRead(m.r[iReg] + (imm5 << 2));
   }
 };
 
@@ -980,17 +2132,26 @@ public:
     iReg = (inCode >> 3) & 0b111;
   }
   virtual uint8_t memAccessCount() { return 1; }
-  virtual void Print() {
-    printf("%x: str.b r%d, [r%d, #%d]", addr, sReg, iReg, imm5);
-  }
-  virtual void romeoFuncContent() {
-    printf("  uint32_t addr = ");
-    pReg(iReg);
-    printf(" + %d;\n", imm5);
-    printf("  uint8_t op = (");
-    pReg(sReg);
-    printf(" & 255);\n");
-    printf("  memWrite8(mem, addr, op);\n");
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": str.b r" << sReg << ", [r" << iReg << ", #" << imm5
+        << "]";
+  }
+  virtual uint16_t readRegs() { return (1 << iReg) | (1 << sReg); }
+  virtual void absExec(AbsState_t &s) {
+    s.store(s.r[iReg].plus(imm5), s.r[sReg], false);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint32_t addr = ";
+    pReg(out, iReg);
+    out << " + " << imm5 << ";\n";
+    out << "  uint8_t op = (";
+    pReg(out, sReg);
+    out << " & 255);\n";
+    dataAccess(out, "addr", true);
+    out << "  memWrite8" << memSuffix() << "(" << memArgs() << " addr, op);\n";
+  }
+  virtual void exec(Machine_t &m) {
+    m.memWrite8(m.r[iReg] + imm5, m.r[sReg] & 255);
   }
 };
 
@@ -1004,16 +2165,26 @@ public:
     iReg = (inCode >> 3) & 0b111;
   }
   virtual uint8_t memAccessCount() { return 1; }
-  virtual void Print() {
-    printf("%x: ldr.b r%d, [r%d, #%d]", addr, dReg, iReg, imm5);
-  }
-  virtual void romeoFuncContent() {
-    printf("  uint32_t addr = ");
-    pReg(iReg);
-    printf(" + %d;\n", imm5);
-    printf("  uint32_t data = memRead8(mem, addr);\n");
-    wReg(dReg);
-    printf(" data;\n");
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": ldr.b r" << dReg << ", [r" << iReg << ", #" << imm5
+        << "]";
+  }
+  virtual uint16_t readRegs() { return 1 << iReg; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[dReg] = s.load(s.r[iReg].plus(imm5), false);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint32_t addr = ";
+    pReg(out, iReg);
+    out << " + " << imm5 << ";\n";
+    dataAccess(out, "addr", false);
+    out << "  uint32_t data = memRead8" << memSuffix() << "(" << memArgs() << " addr);\n";
+    wReg(out, dReg);
+    out << " data;\n";
+  }
+  virtual void exec(Machine_t &m) {
+    m.r[dReg] = m.memRead8(m.r[iReg] + imm5);
   }
 };
 
@@ -1051,20 +2222,30 @@ public:
     iReg = (inCode >> 3) & 0b111;
   }
 
-  virtual void Print() {
-    printf("%x: strh r%d, [r%d, #%d]", addr, sReg, iReg, imm5 << 2);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": strh r" << sReg << ", [r" << iReg << ", #"
+        << (imm5 << 2) << "]";
   }
 
   virtual uint8_t memAccessCount() { return 1; }
 
-  virtual void romeoFuncContent() {
-    printf("  uint32_t address = ");
-    pReg(iReg);
-    printf(" + %d;\n", imm5 << 1);
-    printf("  uint16_t data = ");
-    pReg(sReg);
-    printf(" & 0x0000FFFF;\n");
-    printf("  memWrite16(mem, address, data);\n");
+  virtual uint16_t readRegs() { return (1 << iReg) | (1 << sReg); }
+  virtual void absExec(AbsState_t &s) {
+    s.store(s.r[iReg].plus(imm5 << 1), s.r[sReg], false);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint32_t address = ";
+    pReg(out, iReg);
+    out << " + " << (imm5 << 1) << ";\n";
+    out << "  uint16_t data = ";
+    pReg(out, sReg);
+    out << " & 0x0000FFFF;\n";
+    dataAccess(out, "address", true);
+    out << "  memWrite16" << memSuffix() << "(" << memArgs() << " address, data);\n";
+  }
+  virtual void exec(Machine_t &m) {
+    m.memWrite16(m.r[iReg] + (imm5 << 1),
+                 m.r[sReg] & 0x0000FFFF);
   }
 };
 
@@ -1079,17 +2260,27 @@ public:
     iReg = (inCode >> 3) & 0b111;
   }
 
-  virtual void Print() {
-    printf("%x: ldr.w r%d, [r%d, #%d]", addr, dReg, iReg, imm5 << 2);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": ldr.w r" << dReg << ", [r" << iReg << ", #"
+        << (imm5 << 2) << "]";
   }
 
   virtual uint8_t memAccessCount() { return 1; }
 
-  virtual void romeoFuncContent() {
-    wReg(dReg);
-    printf("memRead16(mem, ");
-    pReg(iReg);
-    printf(" + %d);\n", imm5 << 2);
+  virtual uint16_t readRegs() { return 1 << iReg; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[dReg] = s.load(s.r[iReg].plus(imm5 << 2), false);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    dataAccess(out, iReg, imm5 << 2, false);
+    wReg(out, dReg);
+    out << "memRead16" << memSuffix() << "(" << memArgs() << " ";
+    pReg(out, iReg);
+    out << " + " << (imm5 << 2) << ");\n";
+  }
+  virtual void exec(Machine_t &m) {
+    m.r[dReg] = m.memRead16(m.r[iReg] + (imm5 << 2));
   }
 };
 
@@ -1135,114 +2326,143 @@ public:
   }
   virtual uint32_t targetIdTaken() { return mTargetIdTaken; }
 
-  void PrintOffset() { printf("%x", addr + (int16_t)(imm8 * 2) + 4); }
+  void PrintOffset(Buffer_t &out) {
+    out << Hex_t(addr + (int16_t)(imm8 * 2) + 4);
+  }
 };
 
 class BNE_t : public CONDBR_t {
 public:
   BNE_t(const uint32_t inAddr, const uint16_t inCode)
       : CONDBR_t(inAddr, inCode) {}
-  virtual void Print() {
-    printf("%x: bne.n ", addr);
-    PrintOffset();
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": bne.n ";
+    PrintOffset(out);
   }
   virtual const char *guard() {
     return "((st[$any].regs.sr & Zmask) #noteq Zmask)";
   }
+  virtual bool taken(const int32_t sr) {
+    return (sr & Machine_t::sZmask) != Machine_t::sZmask;
+  }
 };
 
 class BLT_t : public CONDBR_t {
 public:
   BLT_t(const uint32_t inAddr, const uint16_t inCode)
       : CONDBR_t(inAddr, inCode) {}
-  virtual void Print() {
-    printf("%x: blt.n ", addr);
-    PrintOffset();
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": blt.n ";
+    PrintOffset(out);
   }
   virtual const char *guard() {
     return "(st[$any].regs.sr &  Nmask) #eqeq Nmask";
   }
+  virtual bool taken(const int32_t sr) {
+    return (sr & Machine_t::sNmask) == Machine_t::sNmask;
+  }
 };
 
 class BCS_t : public CONDBR_t {
 public:
   BCS_t(const uint32_t inAddr, const uint16_t inCode)
       : CONDBR_t(inAddr, inCode) {}
-  virtual void Print() {
-    printf("%x: bcs.n ", addr);
-    PrintOffset();
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": bcs.n ";
+    PrintOffset(out);
   }
   virtual const char *guard() {
     return "((st[$any].regs.sr & Cmask) #eqeq Cmask)";
   }
+  virtual bool taken(const int32_t sr) {
+    return (sr & Machine_t::sCmask) == Machine_t::sCmask;
+  }
 };
 
 class BCC_t : public CONDBR_t {
 public:
   BCC_t(const uint32_t inAddr, const uint16_t inCode)
       : CONDBR_t(inAddr, inCode) {}
-  virtual void Print() {
-    printf("%x: bcc.n ", addr);
-    PrintOffset();
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": bcc.n ";
+    PrintOffset(out);
   }
   virtual const char *guard() {
     return "((st[$any].regs.sr & Cmask) #noteq Cmask)";
   }
+  virtual bool taken(const int32_t sr) {
+    return (sr & Machine_t::sCmask) != Machine_t::sCmask;
+  }
 };
 
 class BLE_t : public CONDBR_t {
 public:
   BLE_t(const uint32_t inAddr, const uint16_t inCode)
       : CONDBR_t(inAddr, inCode) {}
-  virtual void Print() {
-    printf("%x: ble.n ", addr);
-    PrintOffset();
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": ble.n ";
+    PrintOffset(out);
   }
   virtual const char *guard() {
     return "((st[$any].regs.sr & Zmask) #eqeq Zmask) || ((st[$any].regs.sr & "
            "Nmask) #eqeq Nmask)";
   }
+  virtual bool taken(const int32_t sr) {
+    return (sr & Machine_t::sZmask) == Machine_t::sZmask ||
+           (sr & Machine_t::sNmask) == Machine_t::sNmask;
+  }
 };
 
 class BEQ_t : public CONDBR_t {
 public:
   BEQ_t(const uint32_t inAddr, const uint16_t inCode)
       : CONDBR_t(inAddr, inCode) {}
-  virtual void Print() {
-    printf("%x: beq.n ", addr);
-    PrintOffset();
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": beq.n ";
+    PrintOffset(out);
   }
   virtual const char *guard() {
     return "((st[$any].regs.sr & Zmask) #eqeq Zmask)";
   }
+  virtual bool taken(const int32_t sr) {
+    return (sr & Machine_t::sZmask) == Machine_t::sZmask;
+  }
 };
 
 class BLS_t : public CONDBR_t {
 public:
   BLS_t(const uint32_t inAddr, const uint16_t inCode)
       : CONDBR_t(inAddr, inCode) {}
-  virtual void Print() {
-    printf("%x: bls.n ", addr);
-    PrintOffset();
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": bls.n ";
+    PrintOffset(out);
   }
   virtual const char *guard() {
     return "((st[$any].regs.sr & Zmask) #eqeq Zmask) || ((st[$any].regs.sr & "
            "Cmask) #noteq Cmask)";
   }
+  virtual bool taken(const int32_t sr) {
+    return (sr & Machine_t::sZmask) == Machine_t::sZmask ||
+           (sr & Machine_t::sCmask) != Machine_t::sCmask;
+  }
 };
 
 class BGE_t : public CONDBR_t {
 public:
   BGE_t(const uint32_t inAddr, const uint16_t inCode)
       : CONDBR_t(inAddr, inCode) {}
-  virtual void Print() {
-    printf("%x: bge.n ", addr);
-    PrintOffset();
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": bge.n ";
+    PrintOffset(out);
   }
   virtual const char *guard() {
     return "((st[$any].regs.sr & Zmask) #eqeq Zmask) || ((st[$any].regs.sr & "
            "Nmask) #noteq Nmask)";
   }
+  virtual bool taken(const int32_t sr) {
+    return (sr & Machine_t::sZmask) == Machine_t::sZmask ||
+           (sr & Machine_t::sNmask) != Machine_t::sNmask;
+  }
 };
 
 class STMIA_t : public Inst_t {
@@ -1254,8 +2474,8 @@ public:
     iReg = (inCode >> 8) & 0b111;
     sRegList = (inCode & 0b11111111);
   }
-  virtual void Print() {
-    printf("%x: stmia r%d!, {", addr, iReg);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": stmia r" << iReg << "!, {";
     uint16_t rn = 0, rl = sRegList;
     bool first = true;
     while (rl != 0) {
@@ -1263,25 +2483,25 @@ public:
         if (first)
           first = false;
         else
-          printf(", ");
+          out << ", ";
         switch (rn) {
         case 13:
-          printf("sp");
+          out << "sp";
           break;
         case 14:
-          printf("lr");
+          out << "lr";
           break;
         case 15:
-          printf("pc");
+          out << "pc";
           break;
         default:
-          printf("r%d", rn);
+          out << "r" << rn;
         }
       }
       rl >>= 1;
       rn++;
     }
-    printf("}");
+    out << "}";
   }
 
   virtual uint8_t memAccessCount() {
@@ -1295,36 +2515,67 @@ public:
     return accessCount;
   }
 
-  virtual void romeoFuncContent() {
+  virtual uint16_t readRegs() { return (1 << iReg) | sRegList; }
+  virtual uint16_t writtenRegs() { return 1 << iReg; }
+  virtual void absExec(AbsState_t &s) {
+    uint16_t regList = sRegList;
+    uint8_t regNum = 0;
+    int32_t regCount = 0;
+    while (regList != 0) {
+      if (regList & 1) {
+        s.store(s.r[iReg].plus(regCount * 4), s.r[regNum], true);
+        regCount++;
+      }
+      regList >>= 1;
+      regNum++;
+    }
+    s.r[iReg] = s.r[iReg].plus(regCount * 4);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
     uint16_t regList = sRegList;
     uint8_t regNum = 0;
     uint8_t regCount = 0;
     while (regList != 0) {
       if (regList & 1) {
-        printf("  memWrite(mem,");
-        pReg(iReg);
-        printf(" + %d, ", regCount * 4);
-        pReg(regNum);
-        printf(");\n");
+        dataAccess(out, iReg, regCount * 4, true);
+        out << "  memWrite" << memSuffix() << "(" << memArgs();
+        pReg(out, iReg);
+        out << " + " << (regCount * 4) << ", ";
+        pReg(out, regNum);
+        out << ");\n";
         regCount++;
       }
       regList >>= 1;
       regNum++;
     }
-    wReg(iReg);
-    pReg(iReg);
-    printf(" + %d;\n", regCount * 4);
+    wReg(out, iReg);
+    pReg(out, iReg);
+    out << " + " << (regCount * 4) << ";\n";
   };
-};
-
-class LDMIA_t : public Inst_t {
-  uint8_t iReg;
-  uint16_t sRegList;
-  bool wBack;
-
-public:
-  LDMIA_t(const uint32_t inAddr, const uint16_t inCode) : Inst_t(inAddr) {
-    iReg = (inCode >> 8) & 0b111;
+  virtual void exec(Machine_t &m) {
+    uint16_t regList = sRegList;
+    uint8_t regNum = 0;
+    uint8_t regCount = 0;
+    while (regList != 0) {
+      if (regList & 1) {
+        m.memWrite(m.r[iReg] + regCount * 4, m.r[regNum]);
+        regCount++;
+      }
+      regList >>= 1;
+      regNum++;
+    }
+    m.r[iReg] = (uint32_t)m.r[iReg] + regCount * 4;
+  }
+};
+
+class LDMIA_t : public Inst_t {
+  uint8_t iReg;
+  uint16_t sRegList;
+  bool wBack;
+
+public:
+  LDMIA_t(const uint32_t inAddr, const uint16_t inCode) : Inst_t(inAddr) {
+    iReg = (inCode >> 8) & 0b111;
     sRegList = (inCode & 0b11111111) | ((inCode & 0b100000000) << 6);
     wBack = true;
     uint16_t rl = sRegList;
@@ -1352,12 +2603,12 @@ public:
     return accessCount;
   }
 
-  virtual void Print() {
-    printf("%x: ldmia r%d", addr, iReg);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": ldmia r" << iReg;
     if (wBack) {
-      printf("!");
+      out << "!";
     }
-    printf(", {");
+    out << ", {";
     uint16_t rn = 0, rl = sRegList;
     bool first = true;
     while (rl != 0) {
@@ -1365,49 +2616,84 @@ public:
         if (first)
           first = false;
         else
-          printf(", ");
+          out << ", ";
         switch (rn) {
         case 13:
-          printf("sp");
+          out << "sp";
           break;
         case 14:
-          printf("lr");
+          out << "lr";
           break;
         case 15:
-          printf("pc");
+          out << "pc";
           break;
         default:
-          printf("r%d", rn);
+          out << "r" << rn;
         }
       }
       rl >>= 1;
       rn++;
     }
-    printf("}");
+    out << "}";
   }
 
-  virtual void romeoFuncContent() {
+  virtual uint16_t readRegs() { return 1 << iReg; }
+  virtual uint16_t writtenRegs() {
+    return sRegList | (wBack ? (1 << iReg) : 0);
+  }
+  virtual void absExec(AbsState_t &s) {
+    uint16_t regList = sRegList;
+    uint8_t regNum = 0;
+    int32_t regCount = 0;
+    while (regList != 0) {
+      if (regList & 1) {
+        s.r[regNum] = s.load(s.r[iReg].plus(regCount * 4), true);
+        regCount++;
+      }
+      regList >>= 1;
+      regNum++;
+    }
+    if (wBack)
+      s.r[iReg] = s.r[iReg].plus(regCount * 4);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
     uint16_t regList = sRegList;
     uint8_t regNum = 0;
     uint8_t regCount = 0;
     while (regList != 0) {
       if (regList & 1) {
-        wReg(regNum);
-        printf("  memRead(mem,");
-        pReg(iReg);
-        printf(" + %d", regCount * 4);
-        printf(");\n");
+        dataAccess(out, iReg, regCount * 4, false);
+        wReg(out, regNum);
+        out << "  memRead" << memSuffix() << "(" << memArgs();
+        pReg(out, iReg);
+        out << " + " << (regCount * 4);
+        out << ");\n";
         regCount++;
       }
       regList >>= 1;
       regNum++;
     }
     if (wBack) {
-      wReg(iReg);
-      pReg(iReg);
-      printf(" + %d;\n", regCount * 4);
+      wReg(out, iReg);
+      pReg(out, iReg);
+      out << " + " << (regCount * 4) << ";\n";
     }
   };
+  virtual void exec(Machine_t &m) {
+    uint16_t regList = sRegList;
+    uint8_t regNum = 0;
+    uint8_t regCount = 0;
+    while (regList != 0) {
+      if (regList & 1) {
+        m.r[regNum] = m.memRead(m.r[iReg] + regCount * 4);
+        regCount++;
+      }
+      regList >>= 1;
+      regNum++;
+    }
+    if (wBack)
+      m.r[iReg] = (uint32_t)m.r[iReg] + regCount * 4;
+  }
 };
 
 Inst_t *Inst_t::decodeThumb6(const uint32_t inAddr, const uint16_t inCode) {
@@ -1462,7 +2748,9 @@ public:
   }
   virtual bool isUncondBranch() { return true; }
   virtual uint32_t branchAddress() { return addr + 4 + imm11 * 2; }
-  virtual void Print() { printf("%x: b.n %x", addr, branchAddress()); }
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": b.n " << Hex_t(branchAddress());
+  }
   virtual void setTargetIdTaken(const uint32_t inTargetId) {
     mTargetIdTaken = inTargetId;
   }
@@ -1537,7 +2825,9 @@ public:
 
   virtual bool isFuncCall() { return true; }
   virtual uint32_t branchAddress() { return addr + 4 + offset; }
-  virtual void Print() { printf("%x: bl %x", addr, addr + 4 + offset); }
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": bl " << Hex_t(addr + 4 + offset);
+  }
   virtual void setTargetIdTaken(const uint32_t inTargetId) {
     mTargetIdTaken = inTargetId;
   }
@@ -1554,20 +2844,31 @@ public:
     mReg = ((inCode) & 0b1111);
   }
 
-  virtual void Print() {
-    printf("%x: mul r%d, r%d, r%d", addr, dReg, nReg, mReg);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": mul r" << dReg << ", r" << nReg << ", r" << mReg;
   }
+  virtual bool isMultiply() { return true; }
 
-  virtual void romeoFuncContent() {
-    printf("  uint64_t op1 = ");
-    pReg(nReg);
-    printf(";\n  uint64_t op2 = ");
-    pReg(mReg);
-    printf(";\n uint64_t val = op1 * op2;\n");
-    wReg(dReg);
-    printf("val;\n");
-    updateSR("val", "op1", "op2"); // not sure for V
+  virtual uint16_t readRegs() { return (1 << nReg) | (1 << mReg); }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual bool writesFlags() { return true; }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = ";
+    pReg(out, nReg);
+    out << ";\n  uint64_t op2 = ";
+    pReg(out, mReg);
+    out << ";\n uint64_t val = op1 * op2;\n";
+    wReg(out, dReg);
+    out << "val;\n";
+    updateSR(out, "val", "op1", "op2"); // not sure for V
   };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = m.r[nReg];
+    const uint64_t op2 = m.r[mReg];
+    const uint64_t val = op1 * op2;
+    m.r[dReg] = val;
+    m.updateSR(val, op1, op2);
+  }
 };
 
 class SDIV_t : public Inst_t {
@@ -1580,20 +2881,35 @@ public:
     mReg = ((inCode) & 0b1111);
   }
 
-  virtual void Print() {
-    printf("%x: sdiv r%d, r%d, r%d", addr, dReg, nReg, mReg);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": sdiv r" << dReg << ", r" << nReg << ", r" << mReg;
   }
+  virtual bool isDivide() { return true; }
 
-  virtual void romeoFuncContent() {
-    printf("  uint64_t op1 = ");
-    pReg(nReg);
-    printf(";\n  uint64_t op2 = ");
-    pReg(mReg);
-    printf(";\n  uint64_t val = op1 / op2;\n");
-    wReg(dReg);
-    printf("val;\n");
-    updateSR("val", "op1", "op2"); // not sure for V
+  virtual uint16_t readRegs() { return (1 << nReg) | (1 << mReg); }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual bool writesFlags() { return true; }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = ";
+    pReg(out, nReg);
+    out << ";\n  uint64_t op2 = ";
+    pReg(out, mReg);
+    out << ";\n  uint64_t val = op1 / op2;\n";
+    wReg(out, dReg);
+    out << "val;\n";
+    updateSR(out, "val", "op1", "op2"); // not sure for V
   };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = m.r[nReg];
+    const uint64_t op2 = m.r[mReg];
+    if (op2 == 0) {
+      m.setFault(addr);
+      return;
+    }
+    const uint64_t val = op1 / op2;
+    m.r[dReg] = val;
+    m.updateSR(val, op1, op2);
+  }
 };
 
 class ADDimmediate_t : public Inst_t { // encoding T3 A7.7.3
@@ -1613,19 +2929,34 @@ public:
     imm32 = (i << 3 << 8) | (imm3 << 8) | imm8;
   }
 
-  virtual void Print() {
-    printf("%x: add.w r%d, r%d, #%d", addr, dReg, nReg, imm32);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": add.w r" << dReg << ", r" << nReg << ", #"
+        << imm32;
   }
 
-  virtual void romeoFuncContent() {
-    printf("  uint64_t op1 = ");
-    pReg(nReg);
-    printf(";\n  uint64_t op2 = %d;\n", imm32);
-    printf("  uint64_t val = op1 + op2;\n");
-    wReg(dReg);
-    printf("val;\n");
-    updateSR("val", "op1", "op2");
+  virtual uint16_t readRegs() { return 1 << nReg; }
+  virtual uint16_t writtenRegs() { return 1 << dReg; }
+  virtual bool writesFlags() { return true; }
+  virtual void absExec(AbsState_t &s) {
+    s.r[dReg] = s.r[nReg].plus(imm32);
+    s.srTaint = s.r[dReg].taint;
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
+    out << "  uint64_t op1 = ";
+    pReg(out, nReg);
+    out << ";\n  uint64_t op2 = " << imm32 << ";\n";
+    out << "  uint64_t val = op1 + op2;\n";
+    wReg(out, dReg);
+    out << "val;\n";
+    updateSR(out, "val", "op1", "op2");
   };
+  virtual void exec(Machine_t &m) {
+    const uint64_t op1 = m.r[nReg];
+    const uint64_t op2 = imm32;
+    const uint64_t val = op1 + op2;
+    m.r[dReg] = val;
+    m.updateSR(val, op1, op2);
+  }
 };
 
 Inst_t *Inst_t::decodeDataProcessing(const uint32_t inAddr,
@@ -1676,12 +3007,12 @@ public:
 
   virtual uint8_t memAccessCount() { return regCount; }
 
-  virtual void Print() {
-    printf("%x: ldmia.w r%d", addr, iReg);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": ldmia.w r" << iReg;
     if (wBack) {
-      printf("!");
+      out << "!";
     }
-    printf(", {");
+    out << ", {";
     uint16_t rn = 0, rl = sRegList;
     bool first = true;
     while (rl != 0) {
@@ -1689,49 +3020,84 @@ public:
         if (first)
           first = false;
         else
-          printf(", ");
+          out << ", ";
         switch (rn) {
         case 13:
-          printf("sp");
+          out << "sp";
           break;
         case 14:
-          printf("lr");
+          out << "lr";
           break;
         case 15:
-          printf("pc");
+          out << "pc";
           break;
         default:
-          printf("r%d", rn);
+          out << "r" << rn;
         }
       }
       rl >>= 1;
       rn++;
     }
-    printf("}");
+    out << "}";
   }
 
-  virtual void romeoFuncContent() {
+  virtual uint16_t readRegs() { return 1 << iReg; }
+  virtual uint16_t writtenRegs() {
+    return sRegList | (wBack ? (1 << iReg) : 0);
+  }
+  virtual void absExec(AbsState_t &s) {
+    uint32_t regList = sRegList;
+    uint32_t regNum = 0;
+    int32_t offset = 0;
+    while (regList != 0) {
+      if (regList & 1) {
+        s.r[regNum] = s.load(s.r[iReg].plus(offset * 4), true);
+        offset++;
+      }
+      regList >>= 1;
+      regNum++;
+    }
+    if (wBack)
+      s.r[iReg] = s.r[iReg].plus(regCount * 4);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
     uint32_t regList = sRegList;
     uint32_t regNum = 0;
     uint32_t offset = 0;
     while (regList != 0) {
       if (regList & 1) {
-        wReg(regNum);
-        printf("  memRead(mem,");
-        pReg(iReg);
-        printf(" + %d", offset * 4);
-        printf(");\n");
+        dataAccess(out, iReg, offset * 4, false);
+        wReg(out, regNum);
+        out << "  memRead" << memSuffix() << "(" << memArgs();
+        pReg(out, iReg);
+        out << " + " << (offset * 4);
+        out << ");\n";
         offset++;
       }
       regList >>= 1;
       regNum++;
     }
     if (wBack) {
-      wReg(iReg);
-      pReg(iReg);
-      printf(" + %d;\n", regCount * 4);
+      wReg(out, iReg);
+      pReg(out, iReg);
+      out << " + " << (regCount * 4) << ";\n";
     }
   };
+  virtual void exec(Machine_t &m) {
+    uint32_t regList = sRegList;
+    uint32_t regNum = 0;
+    uint32_t offset = 0;
+    while (regList != 0) {
+      if (regList & 1) {
+        m.r[regNum] = m.memRead(m.r[iReg] + offset * 4);
+        offset++;
+      }
+      regList >>= 1;
+      regNum++;
+    }
+    if (wBack)
+      m.r[iReg] = (uint32_t)m.r[iReg] + regCount * 4;
+  }
 };
 
 class STMIA32_t : public Inst_t {
@@ -1755,12 +3121,12 @@ public:
     }
   }
 
-  virtual void Print() {
-    printf("%x: stmia.w r%d", addr, iReg);
+  virtual void Print(Buffer_t &out) {
+    out << Hex_t(addr) << ": stmia.w r" << iReg;
     if (wBack) {
-      printf("!");
+      out << "!";
     }
-    printf(", {");
+    out << ", {";
     uint16_t rn = 0, rl = sRegList;
     bool first = true;
     while (rl != 0) {
@@ -1768,51 +3134,84 @@ public:
         if (first)
           first = false;
         else
-          printf(", ");
+          out << ", ";
         switch (rn) {
         case 13:
-          printf("sp");
+          out << "sp";
           break;
         case 14:
-          printf("lr");
+          out << "lr";
           break;
         case 15:
-          printf("pc");
+          out << "pc";
           break;
         default:
-          printf("r%d", rn);
+          out << "r" << rn;
         }
       }
       rl >>= 1;
       rn++;
     }
-    printf("}");
+    out << "}";
   }
 
   virtual uint8_t memAccessCount() { return regCount; }
 
-  virtual void romeoFuncContent() {
+  virtual uint16_t readRegs() { return (1 << iReg) | sRegList; }
+  virtual uint16_t writtenRegs() { return wBack ? (1 << iReg) : 0; }
+  virtual void absExec(AbsState_t &s) {
+    uint16_t regList = sRegList;
+    uint8_t regNum = 0;
+    int32_t offset = 0;
+    while (regList != 0) {
+      if (regList & 1) {
+        s.store(s.r[iReg].plus(offset * 4), s.r[regNum], true);
+        offset++;
+      }
+      regList >>= 1;
+      regNum++;
+    }
+    if (wBack)
+      s.r[iReg] = s.r[iReg].plus(regCount * 4);
+  }
+  virtual void romeoFuncContent(Buffer_t &out) {
     uint16_t regList = sRegList;
     uint8_t regNum = 0;
     uint8_t offset = 0;
     while (regList != 0) {
       if (regList & 1) {
-        printf("  memWrite(mem,");
-        pReg(iReg);
-        printf(" + %d, ", offset * 4);
-        pReg(regNum);
-        printf(");\n");
+        dataAccess(out, iReg, offset * 4, true);
+        out << "  memWrite" << memSuffix() << "(" << memArgs();
+        pReg(out, iReg);
+        out << " + " << (offset * 4) << ", ";
+        pReg(out, regNum);
+        out << ");\n";
         offset++;
       }
       regList >>= 1;
       regNum++;
     }
     if (wBack) {
-      wReg(iReg);
-      pReg(iReg);
-      printf(" + %d;\n", regCount * 4);
+      wReg(out, iReg);
+      pReg(out, iReg);
+      out << " + " << (regCount * 4) << ";\n";
     }
   };
+  virtual void exec(Machine_t &m) {
+    uint16_t regList = sRegList;
+    uint8_t regNum = 0;
+    uint8_t offset = 0;
+    while (regList != 0) {
+      if (regList & 1) {
+        m.memWrite(m.r[iReg] + offset * 4, m.r[regNum]);
+        offset++;
+      }
+      regList >>= 1;
+      regNum++;
+    }
+    if (wBack)
+      m.r[iReg] = (uint32_t)m.r[iReg] + regCount * 4;
+  }
 };
 
 /*
@@ -1939,21 +3338,412 @@ Inst_t *Inst_t::decodeARM32(const uint32_t inAddr, const uint32_t inCode) {
   return NULL;
 }
 
-void generatePlace(FILE *prog, Inst_t *inst, uint32_t depth) {
-  fprintf(prog,
-          "<place id=\"%d\" identifier=\"INST%x\" label=\"INST%x\" "
-          "initialMarking=\"0\" eft=\"0\" lft=\"0\">\n",
-          inst->placeId(), inst->address(), inst->address());
-  fprintf(prog, "    <graphics color=\"0\">\n");
-  fprintf(prog, "        <position x=\"%.1f\" y=\"%.1f\"/>\n",
-          depth * 200 + 151.0, 90 * inst->placeId() + 61.0);
-  fprintf(prog, "        <deltaLabel deltax=\"50\" deltay=\"-5\"/>\n");
-  fprintf(prog, "    </graphics>\n    <scheduling gamma=\"0\" "
-                "omega=\"0\"/>\n</place>\n");
+/*
+ * Parallel emission. The elements 0 to count - 1 are formatted by a pool of
+ * jobs threads, by chunks of consecutive elements each written in its own
+ * buffer. A thread takes the next chunk when it is done with the previous
+ * one. The buffers are then appended in order, so the output does not depend
+ * on the number of threads.
+ */
+void parallelEmit(Buffer_t &out, const size_t count, const unsigned jobs,
+                  const function<void(Buffer_t &, size_t)> &format) {
+  const size_t chunkSize = 64;
+  const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+  if (jobs <= 1 || chunkCount <= 1) {
+    for (size_t k = 0; k < count; k++)
+      format(out, k);
+    return;
+  }
+  vector<Buffer_t> chunks(chunkCount);
+  atomic<size_t> nextChunk(0);
+  auto worker = [&]() {
+    size_t chunk;
+    while ((chunk = nextChunk++) < chunkCount) {
+      const size_t end = min(count, (chunk + 1) * chunkSize);
+      for (size_t k = chunk * chunkSize; k < end; k++)
+        format(chunks[chunk], k);
+    }
+  };
+  vector<thread> pool;
+  for (unsigned t = 1; t < min<size_t>(jobs, chunkCount); t++)
+    pool.push_back(thread(worker));
+  worker();
+  for (auto t = pool.begin(); t != pool.end(); ++t)
+    t->join();
+  for (auto c = chunks.begin(); c != chunks.end(); ++c)
+    out << *c;
+}
+
+/*===========================================================================*/
+
+/*
+ * Partial order reduction. The instruction transitions I<addr> only access
+ * the state of their core, indexed by $any. They are independent of the
+ * transitions of the other cores and, if on their own core no transition
+ * accessing the same variables can be enabled at the same time, firing them
+ * first among the transitions firable at the same date keeps one
+ * interleaving out of all the equivalent ones. With --mcpu, they wait for
+ * the cycles of their instruction first: the priority does not change
+ * their date, the other cores running meanwhile. This is checked on the hardware models (--input) and
+ * encoded as a priority of the instruction transitions over the hardware.
+ */
+
+/* transition of a net read from a Roméo file */
+struct NetTransition_t {
+  uint32_t id;
+  string identifier;
+  string guard;
+  string update;
+  int32_t eft, lft;
+  vector<uint32_t> in, out; // places, once per token
+};
+
+struct Net_t {
+  map<uint32_t, uint32_t> marking; // initial marking of each place
+  vector<NetTransition_t> transitions;
+};
+
+/* value of the attribute name of the tag that starts at tag in text */
+bool xmlAttribute(const string &text, const size_t tag, const char *name,
+                  string &value) {
+  const size_t tagEnd = text.find('>', tag);
+  const string key = string(" ") + name + "=\"";
+  const size_t start = text.find(key, tag);
+  if (start == string::npos || start > tagEnd)
+    return false;
+  const size_t first = start + key.size();
+  const size_t last = text.find('"', first);
+  if (last == string::npos)
+    return false;
+  value.clear();
+  static const char *const entities[][2] = {
+      {"&amp;", "&"}, {"&lt;", "<"}, {"&gt;", ">"}, {"&quot;", "\""}};
+  for (size_t k = first; k < last; k++) {
+    bool entity = false;
+    for (auto e = begin(entities); e != end(entities) && !entity; ++e) {
+      if (text.compare(k, strlen((*e)[0]), (*e)[0]) == 0) {
+        value += (*e)[1];
+        k += strlen((*e)[0]) - 1;
+        entity = true;
+      }
+    }
+    if (!entity)
+      value += text[k];
+  }
+  return true;
+}
+
+uint32_t xmlUnsigned(const string &text, const size_t tag, const char *name) {
+  string value;
+  return xmlAttribute(text, tag, name, value) ? strtoul(value.c_str(), NULL, 0)
+                                              : 0;
+}
+
+/* places, transitions and arcs of a Roméo net */
+bool readNet(const char *fileName, Net_t &net) {
+  FILE *file = fopen(fileName, "r");
+  if (file == NULL) {
+    perror(fileName);
+    return false;
+  }
+  string text;
+  char block[1 << 16];
+  size_t size;
+  while ((size = fread(block, 1, sizeof(block), file)) > 0)
+    text.append(block, size);
+  fclose(file);
+
+  map<uint32_t, size_t> transitionIndex;
+  for (size_t tag = text.find("<place "); tag != string::npos;
+       tag = text.find("<place ", tag + 1))
+    net.marking[xmlUnsigned(text, tag, "id")] =
+        xmlUnsigned(text, tag, "initialMarking");
+  for (size_t tag = text.find("<transition "); tag != string::npos;
+       tag = text.find("<transition ", tag + 1)) {
+    NetTransition_t t;
+    t.id = xmlUnsigned(text, tag, "id");
+    xmlAttribute(text, tag, "identifier", t.identifier);
+    xmlAttribute(text, tag, "guard", t.guard);
+    t.eft = xmlUnsigned(text, tag, "eft");
+    t.lft = xmlUnsigned(text, tag, "lft");
+    const size_t end = text.find("</transition>", tag);
+    const size_t update = text.find("<update><![CDATA[", tag);
+    if (update != string::npos && update < end) {
+      const size_t first = update + strlen("<update><![CDATA[");
+      t.update = text.substr(first, text.find("]]>", first) - first);
+    }
+    transitionIndex[t.id] = net.transitions.size();
+    net.transitions.push_back(t);
+  }
+  for (size_t tag = text.find("<arc "); tag != string::npos;
+       tag = text.find("<arc ", tag + 1)) {
+    auto t = transitionIndex.find(xmlUnsigned(text, tag, "transition"));
+    if (t == transitionIndex.end())
+      continue;
+    string type;
+    xmlAttribute(text, tag, "type", type);
+    const uint32_t place = xmlUnsigned(text, tag, "place");
+    const uint32_t weight = xmlUnsigned(text, tag, "weight");
+    for (uint32_t k = 0; k < weight; k++) {
+      if (type == "PlaceTransition")
+        net.transitions[t->second].in.push_back(place);
+      else if (type == "TransitionPlace")
+        net.transitions[t->second].out.push_back(place);
+    }
+  }
+  return true;
+}
+
+/*
+ * Variables read and written by a guard or an update. The variables of a
+ * core are named with their [$any] index (e.g. ac[$any]), the shared ones
+ * without. The function calls, the fields and #operators are skipped.
+ */
+struct Access_t {
+  set<string> read, written;
+
+  void add(const string &code, const bool isUpdate) {
+    size_t statement = 0;
+    while (statement < code.size()) {
+      size_t end = code.find(';', statement);
+      if (end == string::npos)
+        end = code.size();
+      // first '=' that is not part of a comparison
+      size_t assign = string::npos;
+      for (size_t k = statement; isUpdate && k < end; k++) {
+        if (code[k] == '=' && (k + 1 >= end || code[k + 1] != '=') &&
+            k > statement && !strchr("=!<>", code[k - 1])) {
+          assign = k;
+          break;
+        }
+      }
+      for (size_t k = statement; k < end;) {
+        if (!isalpha(code[k]) && code[k] != '_') {
+          k++;
+          continue;
+        }
+        const size_t first = k;
+        while (k < end && (isalnum(code[k]) || code[k] == '_'))
+          k++;
+        if (first > 0 && strchr("#.$", code[first - 1]))
+          continue;
+        size_t next = k;
+        while (next < end && isspace(code[next]))
+          next++;
+        if (next < end && code[next] == '(')
+          continue;
+        string name = code.substr(first, k - first);
+        if (name == "if" || name == "else" || name == "int")
+          continue;
+        if (code.compare(next, 6, "[$any]") == 0)
+          name += "[$any]";
+        if (first < assign)
+          written.insert(name);
+        else
+          read.insert(name);
+      }
+      statement = end + 1;
+    }
+  }
+
+  /* conflict on the shared variables only or on all the variables */
+  bool conflicts(const Access_t &other, const bool sharedOnly) const {
+    auto meets = [&](const set<string> &a, const set<string> &b) {
+      for (auto v = a.begin(); v != a.end(); ++v)
+        if (b.count(*v) != 0 && (!sharedOnly || v->find('[') == string::npos))
+          return true;
+      return false;
+    };
+    return meets(written, other.read) || meets(written, other.written) ||
+           meets(read, other.written);
+  }
+};
+
+/* guard or update without blanks, the Roméo operators written in C */
+string normalizedCode(const string &guard) {
+  string result;
+  for (size_t k = 0; k < guard.size(); k++) {
+    if (guard.compare(k, 5, "#eqeq") == 0) {
+      result += "==";
+      k += 4;
+    } else if (!isspace(guard[k])) {
+      result += guard[k];
+    }
+  }
+  return result;
+}
+
+/*
+ * Checks that the instruction transitions can have priority over the
+ * transitions of the hardware models. They are only enabled when doFetch is
+ * 1 and a hardware transition accessing the same variables of the core must
+ * then be disabled: either its guard requires doFetch to be 0, or it takes
+ * a token of a one token component of the net (a set of places whose
+ * marking sum is 1 in every marking) that is elsewhere while doFetch is 1.
+ * That holds when the transitions setting doFetch to 1 put the token in one
+ * of the fetch places of the component (P8 after Fetch1, or P9 after
+ * ExeBuffered with a prefetch buffer), and the transitions taking it from
+ * there require doFetch to be 0 (doFetch is initially 0 in declarations.c).
+ * Prints the reason when the check fails.
+ */
+bool checkInstructionPriority(const vector<const char *> &inputs) {
+  static const char *const flag = "doFetch[$any]";
+  if (inputs.empty()) {
+    fprintf(stderr, "No priority: the hardware model (--input) is needed\n");
+    return false;
+  }
+  // as written by lowGenerateTransition()
+  Access_t inst;
+  inst.add("doFetch[$any] #eqeq 1 && st[$any].regs.sr", false);
+  inst.add("isHit[$any] = inst(" + Inst_t::funcArgs("$any") +
+               "); doFetch[$any] = 0; ac[$any] = 0;" +
+               (Inst_t::prefetch() ? " buffered[$any] = 0;" : ""),
+           true);
+
+  for (auto input = inputs.begin(); input != inputs.end(); ++input) {
+    Net_t net;
+    if (!readNet(*input, net))
+      return false;
+    auto requiresNoFetch = [&](const NetTransition_t &t) {
+      return normalizedCode(t.guard).find(string(flag) + "==0") !=
+             string::npos;
+    };
+
+    /* places where the one token components hold the token while doFetch
+       is 1, sets of places as bit masks */
+    vector<uint32_t> places;
+    for (auto p = net.marking.begin(); p != net.marking.end(); ++p)
+      places.push_back(p->first);
+    auto bit = [&](const uint32_t place) {
+      for (uint32_t k = 0; k < places.size(); k++)
+        if (places[k] == place)
+          return 1u << k;
+      return 0u;
+    };
+    vector<pair<uint32_t, uint32_t>> components; // component, fetch places
+    for (uint32_t s = 1; places.size() <= 16 && s < (1u << places.size());
+         s++) {
+      auto inS = [&](const uint32_t place) { return (s & bit(place)) != 0; };
+      uint32_t tokens = 0;
+      for (uint32_t k = 0; k < places.size(); k++)
+        if ((s >> k) & 1)
+          tokens += net.marking[places[k]];
+      bool valid = tokens == 1;
+      uint32_t fetchPlaces = 0;
+      for (auto t = net.transitions.begin();
+           valid && t != net.transitions.end(); ++t) {
+        uint32_t taken = 0, given = 0, givenPlace = 0;
+        for (auto p = t->in.begin(); p != t->in.end(); ++p)
+          taken += inS(*p);
+        for (auto p = t->out.begin(); p != t->out.end(); ++p)
+          if (inS(*p)) {
+            given++;
+            givenPlace = *p;
+          }
+        valid = taken == given;
+        const string update = normalizedCode(t->update) + ";";
+        if (valid && update.find(string(flag) + "=") != string::npos) {
+          // doFetch is set to 1 by a single token move to a fetch place
+          if (update.find(string(flag) + "=0") != string::npos)
+            continue;
+          valid = update.find(string(flag) + "=1;") != string::npos &&
+                  given == 1;
+          fetchPlaces |= bit(givenPlace);
+        }
+      }
+      for (auto t = net.transitions.begin();
+           valid && fetchPlaces != 0 && t != net.transitions.end(); ++t)
+        for (auto p = t->in.begin(); p != t->in.end(); ++p)
+          if ((fetchPlaces & bit(*p)) != 0 && !requiresNoFetch(*t))
+            valid = false;
+      if (valid && fetchPlaces != 0)
+        components.push_back(make_pair(s, fetchPlaces));
+    }
+
+    for (auto t = net.transitions.begin(); t != net.transitions.end(); ++t) {
+      Access_t hw;
+      hw.add(t->guard, false);
+      hw.add(t->update, true);
+      if (hw.conflicts(inst, true)) {
+        fprintf(stderr, "No priority: %s shares variables with the "
+                        "instructions\n",
+                t->identifier.c_str());
+        return false;
+      }
+      if (!hw.conflicts(inst, false) || requiresNoFetch(*t))
+        continue;
+      bool disabled = false;
+      for (auto c = components.begin(); c != components.end(); ++c)
+        for (auto p = t->in.begin(); p != t->in.end(); ++p)
+          for (uint32_t k = 0; k < places.size(); k++)
+            if (places[k] == *p && ((c->first >> k) & 1) &&
+                !((c->second >> k) & 1))
+              disabled = true;
+      if (!disabled) {
+        fprintf(stderr, "No priority: %s may fire with an instruction "
+                        "of its core\n",
+                t->identifier.c_str());
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/*
+ * Subnet of the program of a core. With one core, the transitions index the
+ * state of the core with the color of the token ($any), as the hardware
+ * model does. With several cores, each core has its own copy of the net of
+ * its program, where the index is the number of the core and the ids are
+ * shifted; the places and transitions of the copy are prefixed with C<core>_
+ * except for the core 0.
+ */
+struct CoreNet_t {
+  vector<Inst_t *> *program;
+  vector<Word_t *> *words;
+  vector<uint32_t> *stopAddresses;
+  string index;  // of the core in the guards and updates
+  string prefix; // of the places and transitions
+  uint32_t placeOffset;
+  uint32_t transitionOffset;
+
+  /* guard or update of the instruction, for the core of the net */
+  string code(const string &text) const {
+    string result = text;
+    for (size_t k = result.find("$any"); k != string::npos;
+         k = result.find("$any", k + index.size()))
+      result.replace(k, 4, index);
+    return result;
+  }
+};
+
+/*
+ * In compact mode, the layout of the net (graphics, nails, indentation) is
+ * not written and neither are the line breaks between the elements nor the
+ * spaces of the update code: the net is only read by Roméo.
+ */
+void generatePlace(Buffer_t &prog, const bool compact, const CoreNet_t &net,
+                   Inst_t *inst, uint32_t depth, const bool marked = false) {
+  prog << "<place id=\"" << inst->placeId() + net.placeOffset
+       << "\" identifier=\"" << net.prefix.c_str() << "INST"
+       << Hex_t(inst->address()) << "\" label=\"" << net.prefix.c_str()
+       << "INST" << Hex_t(inst->address()) << "\" initialMarking=\""
+       << (marked ? '1' : '0') << "\" eft=\"0\" lft=\"0\">";
+  if (compact) {
+    prog << "<scheduling gamma=\"0\" omega=\"0\"/></place>";
+    return;
+  }
+  prog << "\n    <graphics color=\"0\">\n";
+  prog << "        <position x=\"" << Fixed_t(depth * 200 + 151.0) << "\" y=\""
+       << Fixed_t(90 * inst->placeId() + 61.0) << "\"/>\n";
+  prog << "        <deltaLabel deltax=\"50\" deltay=\"-5\"/>\n";
+  prog << "    </graphics>\n    <scheduling gamma=\"0\" "
+          "omega=\"0\"/>\n</place>\n";
 }
 
-void lowGenerateTransition(FILE *prog, Inst_t *inst, uint32_t depth,
-                           const bool condBr = false,
+void lowGenerateTransition(Buffer_t &prog, const bool compact,
+                           const CoreNet_t &net, Inst_t *inst, uint32_t depth,
+                           const uint32_t priority, const bool condBr = false,
                            const bool taken = false) {
   float offsetX = 0.0;
   float offsetY = 0.0;
@@ -1972,46 +3762,69 @@ void lowGenerateTransition(FILE *prog, Inst_t *inst, uint32_t depth,
     suffix = "";
   }
 
-  fprintf(prog,
-          "<transition id=\"%d\" identifier=\"I%x%s\" label=\"I%x%s\" "
-          "eft=\"0\" lft=\"0\" speed=\"1\" cost=\"0\" unctrl=\"0\" "
-          "obs=\"1\"",
-          transitionId, inst->address(), suffix, inst->address(), suffix);
+  const Interval_t cycles = inst->cycles(taken);
+  prog << "<transition id=\"" << transitionId + net.transitionOffset
+       << "\" identifier=\"" << net.prefix.c_str() << 'I'
+       << Hex_t(inst->address()) << suffix << "\" label=\""
+       << net.prefix.c_str() << 'I' << Hex_t(inst->address()) << suffix
+       << "\" eft=\"" << cycles.eft << "\" lft=\"" << cycles.lft
+       << "\" speed=\"1\"";
+  if (priority != 0)
+    prog << " priority=\"" << priority << '"';
+  prog << " cost=\"0\" unctrl=\"0\" obs=\"1\"";
   if (condBr) {
     if (taken) {
-      fprintf(prog, " guard=\"%s && (doFetch[$any] == 1)\">\n", inst->guard());
+      prog << " guard=\""
+           << net.code(string(inst->guard()) + " && (doFetch[$any] == 1)\">")
+                  .c_str();
     } else {
-      fprintf(prog, " guard=\"!(%s) && (doFetch[$any] == 1)\">\n",
-              inst->guard());
+      prog << " guard=\"!("
+           << net.code(string(inst->guard()) + ") && (doFetch[$any] == 1)\">")
+                  .c_str();
     }
   } else {
-    //    fprintf(prog, " guard=\"\">\n");
-    fprintf(prog, " guard=\"doFetch[$any] #eqeq 1\">\n");
-  }
-  fprintf(prog, "    <graphics color=\"0\">\n");
-  fprintf(prog, "        <position x=\"%.1f\" y=\"%.1f\"/>\n",
-          depth * 200 + 151.0 + offsetX * 100,
-          90 * inst->placeId() + 106.0 + offsetY * 45);
-  fprintf(prog, "        <deltaLabel deltax=\"25\" deltay=\"0\"/>\n");
-  fprintf(prog, "        <deltaGuard deltax=\"20\" deltay=\"-20\"/>\n");
-  fprintf(prog, "        <deltaUpdate deltax=\"130\" deltay=\"0\"/>\n");
-  fprintf(prog, "        <deltaSpeed deltax=\"-20\" deltay=\"5\"/>\n");
-  fprintf(prog, "        <deltaCost deltax=\"-20\" deltay=\"5\"/>\n");
-  fprintf(prog, "    </graphics>\n");
-  fprintf(prog,
-          "    <update><![CDATA[isHit[$any] = "
-          "inst%x(st[$any],mem[$any]);\ndoFetch[$any] = 0;\nac[$any] = "
-          "%d;]]></update>\n",
-          inst->address(), inst->memAccessCount());
-  fprintf(prog, "</transition>\n");
-}
-
-void generateTransition(FILE *prog, Inst_t *inst, uint32_t depth) {
+    //    prog << " guard=\"\">";
+    prog << " guard=\"" << net.code("doFetch[$any] #eqeq 1\">").c_str();
+  }
+  if (!compact) {
+    prog << "\n    <graphics color=\"0\">\n";
+    prog << "        <position x=\""
+         << Fixed_t(depth * 200 + 151.0 + offsetX * 100) << "\" y=\""
+         << Fixed_t(90 * inst->placeId() + 106.0 + offsetY * 45) << "\"/>\n";
+    prog << "        <deltaLabel deltax=\"25\" deltay=\"0\"/>\n";
+    prog << "        <deltaGuard deltax=\"20\" deltay=\"-20\"/>\n";
+    prog << "        <deltaUpdate deltax=\"130\" deltay=\"0\"/>\n";
+    prog << "        <deltaSpeed deltax=\"-20\" deltay=\"5\"/>\n";
+    prog << "        <deltaCost deltax=\"-20\" deltay=\"5\"/>\n";
+    prog << "    </graphics>\n    ";
+  }
+  const char *sep = compact ? "" : "\n";
+  const char *assign = compact ? "=" : " = ";
+  const char *index = net.index.c_str();
+  prog << "<update><![CDATA[isHit[" << index << ']' << assign
+       << inst->funcPrefix() << "inst" << Hex_t(inst->address()) << '('
+       << Inst_t::funcArgs(net.index).c_str() << ");" << sep << "doFetch["
+       << index << ']' << assign << "0;";
+  if (!Inst_t::setsAccessCount()) // else set by the function
+    prog << sep << "ac[" << index << ']' << assign << inst->memAccessCount()
+         << ';';
+  if (Inst_t::prefetch())
+    prog << sep << "buffered[" << index << ']' << assign
+         << (inst->nextBuffered() ? 1 : 0) << ';';
+  prog << "]]></update>";
+  prog << (compact ? "</transition>" : "\n</transition>\n");
+}
+
+void generateTransition(Buffer_t &prog, const bool compact,
+                        const CoreNet_t &net, Inst_t *inst, uint32_t depth,
+                        const uint32_t priority) {
   if (inst->isCondBranch()) {
-    lowGenerateTransition(prog, inst, depth, true, false);
-    lowGenerateTransition(prog, inst, depth, true, true);
+    lowGenerateTransition(prog, compact, net, inst, depth, priority, true,
+                          false);
+    lowGenerateTransition(prog, compact, net, inst, depth, priority, true,
+                          true);
   } else {
-    lowGenerateTransition(prog, inst, depth);
+    lowGenerateTransition(prog, compact, net, inst, depth, priority);
   }
 }
 
@@ -2023,13 +3836,18 @@ bool isStopAddress(const uint32_t stop, vector<uint32_t> &stopAddresses) {
   return false;
 }
 
-void generatePlaces(FILE *prog, vector<Inst_t *> &program,
-                    vector<Word_t *> &words, const uint32_t startAddress,
-                    vector<uint32_t> &stopAddresses, uint32_t depth = 0) {
+/*
+ * Places in the order of the net: the program from startAddress up to a stop
+ * address, the called functions being inserted after their call, one level
+ * deeper.
+ */
+void collectPlaces(vector<pair<Inst_t *, uint32_t>> &places,
+                   vector<Inst_t *> &program, vector<Word_t *> &words,
+                   const uint32_t startAddress,
+                   vector<uint32_t> &stopAddresses, uint32_t depth = 0) {
   for (auto i = program.begin(); i != program.end(); ++i) {
     if ((*i)->address() >= startAddress) {
-      generatePlace(prog, *i, depth);
-      generateTransition(prog, *i, depth);
+      places.push_back(make_pair(*i, depth));
       if ((*i)->isFuncCall()) {
         bool found = false;
         for (auto j = program.begin(); j != program.end(); ++j) {
@@ -2038,8 +3856,8 @@ void generatePlaces(FILE *prog, vector<Inst_t *> &program,
           if ((*i)->branchAddress() == (*j)->address()) {
             found = true;
             //            printf("found\n");
-            generatePlaces(prog, program, words, (*i)->branchAddress(),
-                           stopAddresses, depth + 1);
+            collectPlaces(places, program, words, (*i)->branchAddress(),
+                          stopAddresses, depth + 1);
           }
         }
         if (!found) {
@@ -2053,91 +3871,189 @@ void generatePlaces(FILE *prog, vector<Inst_t *> &program,
   }
 }
 
-void genUpArc(FILE *prog, uint32_t place, uint32_t transition) {
-  fprintf(prog,
-          "    <arc place=\"%d\" transition=\"%d\" type=\"PlaceTransition\" "
-          "weight=\"1\" tokenColor=\"-1\"  inhibitingCondition=\"\">\n",
-          place, transition);
-  fprintf(prog, "        <nail xnail=\"0\" ynail=\"0\"/>\n");
-  fprintf(prog, "        <graphics  color=\"0\"></graphics>\n");
-  fprintf(prog, "   </arc>\n");
+void genUpArc(Buffer_t &prog, const bool compact, uint32_t place,
+              uint32_t transition) {
+  prog << (compact ? "<arc place=\"" : "    <arc place=\"") << (int32_t)place
+       << "\" transition=\"" << transition
+       << "\" type=\"PlaceTransition\" weight=\"1\" tokenColor=\"-1\"";
+  if (compact) {
+    prog << " inhibitingCondition=\"\"/>";
+    return;
+  }
+  prog << "  inhibitingCondition=\"\">\n";
+  prog << "        <nail xnail=\"0\" ynail=\"0\"/>\n";
+  prog << "        <graphics  color=\"0\"></graphics>\n";
+  prog << "   </arc>\n";
 }
 
-void genDownArc(FILE *prog, uint32_t place, uint32_t transition,
-                float Xnail = 0.0, float Ynail = 0.0) {
-  fprintf(prog,
-          "    <arc place=\"%d\" transition=\"%d\" type=\"TransitionPlace\" "
-          "weight=\"1\" tokenColor=\"-1\"  inhibitingCondition=\"\">\n",
-          place, transition);
-  fprintf(prog, "        <nail xnail=\"%.1f\" ynail=\"%.1f\"/>\n", Xnail,
-          Ynail);
-  fprintf(prog, "        <graphics  color=\"0\"></graphics>\n");
-  fprintf(prog, "   </arc>\n");
+void genDownArc(Buffer_t &prog, const bool compact, uint32_t place,
+                uint32_t transition, float Xnail = 0.0, float Ynail = 0.0) {
+  prog << (compact ? "<arc place=\"" : "    <arc place=\"") << (int32_t)place
+       << "\" transition=\"" << transition
+       << "\" type=\"TransitionPlace\" weight=\"1\" tokenColor=\"-1\"";
+  if (compact) {
+    prog << " inhibitingCondition=\"\"/>";
+    return;
+  }
+  prog << "  inhibitingCondition=\"\">\n";
+  prog << "        <nail xnail=\"" << Fixed_t(Xnail) << "\" ynail=\""
+       << Fixed_t(Ynail) << "\"/>\n";
+  prog << "        <graphics  color=\"0\"></graphics>\n";
+  prog << "   </arc>\n";
 }
 
-void generateArcs(FILE *prog, vector<Inst_t *> &program,
-                  vector<Word_t *> &words, const uint32_t startAddress) {
-  for (auto i = program.begin(); i != program.end(); ++i) {
-    // arc from place to transition
-    genUpArc(prog, (*i)->placeId(), (*i)->transitionId());
-    if ((*i)->isCondBranch()) {
-      genUpArc(prog, (*i)->placeId(), (*i)->transitionIdTaken());
-      genDownArc(prog, (*(i + 1))->placeId(), (*i)->transitionId());
-      genDownArc(prog, (*i)->targetIdTaken(), (*i)->transitionIdTaken());
-    } else if ((*i)->isUncondBranch()) {
-      genDownArc(prog, (*i)->targetIdTaken(), (*i)->transitionId(), 500.0,
-                 90 * (*i)->placeId() + 536.0);
-    } else if ((*i)->isFuncCall()) {
-      genDownArc(prog, (*i)->targetIdTaken(), (*i)->transitionId(), 500.0,
-                 90 * (*i)->placeId() + 536.0);
-    } else if ((*i)->isFuncReturn()) {
-      genDownArc(prog, (*i)->targetIdTaken(), (*i)->transitionId(), 100.0,
-                 90 * (*i)->placeId() - 536.0);
-    } else {
-      if (*(i + 1) != NULL) {
-        genDownArc(prog, (*(i + 1))->placeId(), (*i)->transitionId());
-      }
+void generateArcs(Buffer_t &prog, const bool compact, const CoreNet_t &net,
+                  const size_t index) {
+  vector<Inst_t *> &program = *net.program;
+  Inst_t *inst = program[index];
+  Inst_t *next = index + 1 < program.size() ? program[index + 1] : NULL;
+  const uint32_t placeId = inst->placeId() + net.placeOffset;
+  const uint32_t transitionId = inst->transitionId() + net.transitionOffset;
+  const uint32_t targetId = inst->targetIdTaken() == (uint32_t)-1
+                                ? inst->targetIdTaken() // no return site
+                                : inst->targetIdTaken() + net.placeOffset;
+  // arc from place to transition
+  genUpArc(prog, compact, placeId, transitionId);
+  if (inst->isCondBranch()) {
+    const uint32_t takenId = inst->transitionIdTaken() + net.transitionOffset;
+    genUpArc(prog, compact, placeId, takenId);
+    if (next != NULL)
+      genDownArc(prog, compact, next->placeId() + net.placeOffset,
+                 transitionId);
+    genDownArc(prog, compact, targetId, takenId);
+  } else if (inst->isUncondBranch()) {
+    genDownArc(prog, compact, targetId, transitionId, 500.0,
+               90 * inst->placeId() + 536.0);
+  } else if (inst->isFuncCall()) {
+    genDownArc(prog, compact, targetId, transitionId, 500.0,
+               90 * inst->placeId() + 536.0);
+  } else if (inst->isFuncReturn()) {
+    genDownArc(prog, compact, targetId, transitionId, 100.0,
+               90 * inst->placeId() - 536.0);
+  } else {
+    if (next != NULL) {
+      genDownArc(prog, compact, next->placeId() + net.placeOffset,
+                 transitionId);
     }
   }
 }
 
-void generatePN(vector<Inst_t *> &program, vector<Word_t *> &words,
-                vector<uint32_t> &stopAddresses) {
-  FILE *prog = fopen("program.xml", "w");
-  filesystem::path dir = filesystem::current_path();
-  // printf("%s\n", dir.c_str());
-  fprintf(prog, "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n");
-  fprintf(prog, "<romeo version=\"Romeo v3.8.4-rc1\"></romeo>\n");
-  fprintf(prog, "<TPN name=\"%s/%s\">\n", dir.c_str(), "program.xml");
-
-  generatePlaces(prog, program, words, 0x8000, stopAddresses);
-  generateArcs(prog, program, words, 0x8000);
+/*
+ * Roméo project. Without output file, the net alone is written to
+ * program.xml in the current directory. Otherwise the project is complete:
+ * the first place holds the token, the net is a slave of the input models
+ * (the hardware) and includes the declarations and instructions files. It
+ * is written to a temporary file that is renamed once complete, so that
+ * concurrent runs never see a partial project.
+ */
+struct Project_t {
+  const char *output;
+  vector<const char *> inputs;
+  vector<const char *> includes;
 
-  fprintf(prog, "<timedCost>-1</timedCost>\n");
-  fprintf(prog, "<nbTokenColor>2</nbTokenColor>\n");
-  fprintf(prog, "<declaration><![CDATA[// insert here the state variables "
-                "declarations\n");
-  fprintf(prog, "// and possibly some code to initialize them\n");
-  fprintf(prog, "// using C-like syntax\n\n");
-  fprintf(prog, "// insert here your type definitions using C-like syntax\n\n");
-  fprintf(prog, "// insert here your function definitions\n");
-  fprintf(prog, "// using C-like syntax]]>\n</declaration>\n\n");
-  fprintf(prog, "<project nbinput=\"0\" openinput=\"0\" nbinclude=\"0\">\n");
-  // fprintf(prog, "    <include id=\"1\" file=\"declarations.c\"/>\n");
-  // fprintf(prog, "    <include id=\"2\" file=\"instructions.c\"/>\n");
-  fprintf(prog, "</project>\n\n");
+  Project_t() : output(NULL) {}
+  bool complete() const { return output != NULL; }
+};
 
-  fprintf(prog, "<preferences>\n");
-  fprintf(prog, "    <colorPlace c0=\"SkyBlue2\" c1=\"gray\" c2=\"cyan\" "
-                "c3=\"green\" c4=\"yellow\" c5=\"brown\"/>\n");
-  fprintf(prog, "    <colorTransition c0=\"yellow\" c1=\"gray\" c2=\"cyan\" "
-                "c3=\"green\" c4=\"SkyBlue2\" c5=\"brown\"/>\n");
-  fprintf(prog, "    <colorArc c0=\"black\" c1=\"gray\" c2=\"blue\" "
-                "c3=\"#beb760\" c4=\"#be5c7e\" c5=\"#46be90\"/>\n");
-  fprintf(prog, "</preferences>\n");
-  fprintf(prog, "</TPN>\n");
+void generateProjectFiles(Buffer_t &prog, const bool compact,
+                          const Project_t &project) {
+  const char *indent = compact ? "" : "\t";
+  const char *eol = compact ? "" : "\n";
+  const char *space = compact ? " " : "  ";
+  prog << "<project nbinput=\"" << project.inputs.size()
+       << "\" openinput=\"0\" nbinclude=\"" << project.includes.size()
+       << "\">" << eol;
+  for (size_t i = 0; i < project.inputs.size(); i++)
+    prog << indent << "<input id=\"" << i + 1 << '"' << space << "file=\""
+         << filesystem::path(project.inputs[i]).filename().c_str() << '"'
+         << space << "status=\"closed\"/>" << eol;
+  for (size_t i = 0; i < project.includes.size(); i++)
+    prog << indent << "<include id=\"" << i + 1 << "\" file=\""
+         << filesystem::path(project.includes[i]).filename().c_str()
+         << "\"/>" << eol;
+}
 
-  fclose(prog);
+/*
+ * Writes the nets of the programs of the cores, the first place of each net
+ * holding a token in a complete project. There is one token color per core,
+ * the net alone being for two cores at least.
+ */
+void generatePN(const vector<CoreNet_t> &nets, const uint32_t cores,
+                const unsigned jobs,
+                const bool compact, const Project_t &project,
+                const uint32_t priority) {
+  filesystem::path path = project.complete()
+                              ? filesystem::absolute(project.output)
+                              : filesystem::current_path() / "program.xml";
+  string tmpName = project.complete()
+                       ? path.string() + ".tmp" + to_string(getpid())
+                       : path.string();
+  const int fd = open(tmpName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    perror(tmpName.c_str());
+    exit(1);
+  }
+  Buffer_t prog(fd);
+  prog << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n";
+  prog << "<romeo version=\"Romeo v3.8.4-rc1\"></romeo>\n";
+  prog << "<TPN name=\"" << path.c_str() << "\">" << (compact ? "" : "\n");
+
+  for (auto net = nets.begin(); net != nets.end(); ++net) {
+    vector<pair<Inst_t *, uint32_t>> places;
+    collectPlaces(places, *net->program, *net->words, 0x8000,
+                  *net->stopAddresses);
+    parallelEmit(prog, places.size(), jobs, [&](Buffer_t &out, size_t k) {
+      Inst_t *inst = places[k].first;
+      generatePlace(out, compact, *net, inst, places[k].second,
+                    project.complete() && inst->placeId() == 1);
+      generateTransition(out, compact, *net, inst, places[k].second,
+                         priority);
+    });
+  }
+  for (auto net = nets.begin(); net != nets.end(); ++net)
+    parallelEmit(prog, net->program->size(), jobs,
+                 [&](Buffer_t &out, size_t k) {
+                   generateArcs(out, compact, *net, k);
+                 });
+
+  const char *eol = compact ? "" : "\n";
+  prog << "<timedCost>-1</timedCost>" << eol;
+  prog << "<nbTokenColor>"
+       << (project.complete() || cores > 2 ? cores : 2)
+       << "</nbTokenColor>" << eol;
+  if (compact) {
+    prog << "<declaration><![CDATA[]]></declaration>";
+    generateProjectFiles(prog, compact, project);
+    prog << "</project>";
+  } else {
+    prog << "<declaration><![CDATA[// insert here the state variables "
+            "declarations\n";
+    prog << "// and possibly some code to initialize them\n";
+    prog << "// using C-like syntax\n\n";
+    prog << "// insert here your type definitions using C-like syntax\n\n";
+    prog << "// insert here your function definitions\n";
+    prog << "// using C-like syntax]]>\n</declaration>\n\n";
+    generateProjectFiles(prog, compact, project);
+    prog << "</project>\n\n";
+
+    prog << "<preferences>\n";
+    prog << "    <colorPlace c0=\"SkyBlue2\" c1=\"gray\" c2=\"cyan\" "
+            "c3=\"green\" c4=\"yellow\" c5=\"brown\"/>\n";
+    prog << "    <colorTransition c0=\"yellow\" c1=\"gray\" c2=\"cyan\" "
+            "c3=\"green\" c4=\"SkyBlue2\" c5=\"brown\"/>\n";
+    prog << "    <colorArc c0=\"black\" c1=\"gray\" c2=\"blue\" "
+            "c3=\"#beb760\" c4=\"#be5c7e\" c5=\"#46be90\"/>\n";
+    prog << "</preferences>\n";
+  }
+  prog << "</TPN>\n";
+
+  prog.flush();
+  if (close(fd) != 0 ||
+      (project.complete() && rename(tmpName.c_str(), path.c_str()) != 0)) {
+    perror(path.c_str());
+    unlink(tmpName.c_str());
+    exit(1);
+  }
 }
 
 uint32_t idFromAddress(vector<Inst_t *> &program, uint32_t inAddr) {
@@ -2191,75 +4107,3737 @@ void genProgData(vector<Inst_t *> &program) {
   printf("\n};\n\n");
 }
 
-void genFuncs(vector<Inst_t *> &program) {
-  for (auto i = program.begin(); i != program.end(); ++i)
-    (*i)->romeoFunc();
+/*
+ * Successors of each instruction (by index in program) in the generated net,
+ * following the arcs written by generateArcs().
+ */
+vector<vector<uint32_t>> computeSuccessors(vector<Inst_t *> &program) {
+  const uint32_t count = program.size();
+  vector<vector<uint32_t>> successors(count);
+  for (uint32_t i = 0; i < count; i++) {
+    Inst_t *inst = program[i];
+    const uint32_t target = inst->targetIdTaken() - 1; // place ids start at 1
+    if (inst->isCondBranch()) {
+      if (i + 1 < count)
+        successors[i].push_back(i + 1);
+      if (target < count)
+        successors[i].push_back(target);
+    } else if (inst->isUncondBranch() || inst->isFuncCall() ||
+               inst->isFuncReturn()) {
+      if (target < count)
+        successors[i].push_back(target);
+    } else if (i + 1 < count) {
+      successors[i].push_back(i + 1);
+    }
+  }
+  return successors;
 }
 
-int main(int argc, char *argv[]) {
-
-  if (argc < 2) {
-    printf("Usage: extract <stop address> [, <stop address>]\n");
-    return 1;
+/*
+ * Basic blocks of the program reachable from its first instruction, by
+ * index of their first instruction. A block ends with a branch, a call or a
+ * return, or before the first instruction of another block. The blocks
+ * starting with a stop address are not simulated.
+ */
+void computeBlocks(vector<Inst_t *> &program, vector<uint32_t> &stopAddresses,
+                   vector<uint32_t> &blocks, vector<uint32_t> &blockEnds) {
+  const uint32_t count = program.size();
+  vector<vector<uint32_t>> successors = computeSuccessors(program);
+  vector<bool> leader(count, false);
+  if (count > 0)
+    leader[0] = true;
+  for (uint32_t i = 0; i < count; i++) {
+    Inst_t *inst = program[i];
+    if (inst->isCondBranch() || inst->isUncondBranch() ||
+        inst->isFuncCall() || inst->isFuncReturn()) {
+      for (auto s = successors[i].begin(); s != successors[i].end(); ++s)
+        leader[*s] = true;
+      if (i + 1 < count)
+        leader[i + 1] = true;
+    }
+    if (isStopAddress(inst->address(), stopAddresses))
+      leader[i] = true;
+  }
+  vector<bool> visited(count, false);
+  vector<uint32_t> pending;
+  if (count > 0)
+    pending.push_back(0);
+  while (!pending.empty()) {
+    const uint32_t first = pending.back();
+    pending.pop_back();
+    if (visited[first] ||
+        isStopAddress(program[first]->address(), stopAddresses))
+      continue;
+    visited[first] = true;
+    uint32_t last = first;
+    while (last + 1 < count && !leader[last + 1] &&
+           successors[last].size() == 1 && successors[last][0] == last + 1)
+      last++;
+    blocks.push_back(first);
+    blockEnds.push_back(last);
+    for (auto s = successors[last].begin(); s != successors[last].end(); ++s)
+      pending.push_back(*s);
   }
+}
 
-  vector<uint32_t> stopAddresses;
-  for (uint32_t i = 1; i < argc; i++) {
-    uint32_t stopAddress = strtol(argv[1], NULL, 0);
-    stopAddresses.push_back(stopAddress);
+/* live registers, status register and memory words */
+class LiveSet_t {
+public:
+  uint16_t regs;
+  bool sr;
+  bool allMem;
+  set<uint64_t> mem;
+
+  LiveSet_t() : regs(0), sr(false), allMem(false) {}
+
+  bool join(const LiveSet_t &other) {
+    const size_t memSize = mem.size();
+    const bool changed = (other.regs & ~regs) || (other.sr && !sr) ||
+                         (other.allMem && !allMem);
+    regs |= other.regs;
+    sr = sr || other.sr;
+    allMem = allMem || other.allMem;
+    mem.insert(other.mem.begin(), other.mem.end());
+    return changed || mem.size() != memSize;
+  }
+  bool hasMem() const { return allMem || !mem.empty(); }
+};
+
+/*
+ * Secret taint analysis and data abstraction. The registers in secretRegs
+ * and the memory in AbsState_t::sSecretMem are tainted and the taint is
+ * propagated through the generated code (forward analysis). Then a backward
+ * analysis computes which instructions contribute to a conditional branch or
+ * to a tainted value. The other ones are abstracted: they do not change the
+ * timing of the program since the control flow is kept.
+ */
+/*
+ * Forward data flow analysis of the generated code: abstract values and
+ * taint of the state before each instruction, from the initial state of
+ * declarations.c (r13 is the initial stack pointer, the registers in
+ * secretRegs are tainted). visited is set for the instructions reached.
+ */
+void analyzeValues(vector<Inst_t *> &program, const uint16_t secretRegs,
+                   vector<AbsState_t> &in, vector<bool> &visited) {
+  const uint32_t count = program.size();
+  in.assign(count, AbsState_t());
+  visited.assign(count, false);
+  if (count == 0)
+    return;
+  vector<vector<uint32_t>> successors = computeSuccessors(program);
+  for (uint8_t reg = 0; reg < 16; reg++) {
+    if (secretRegs & (1 << reg))
+      in[0].r[reg] = AbsValue_t::top(true);
+    else if (reg == 13)
+      in[0].r[reg] = AbsValue_t(AbsValue_t::STACK, 0, false);
+    else
+      in[0].r[reg] = AbsValue_t::constant(reg);
+  }
+  visited[0] = true;
+  vector<uint32_t> worklist(1, 0);
+  while (!worklist.empty()) {
+    const uint32_t i = worklist.back();
+    worklist.pop_back();
+    AbsState_t out = in[i];
+    program[i]->absExec(out);
+    for (auto s = successors[i].begin(); s != successors[i].end(); ++s) {
+      if (!visited[*s]) {
+        visited[*s] = true;
+        in[*s] = out;
+        worklist.push_back(*s);
+      } else if (in[*s].join(out)) {
+        worklist.push_back(*s);
+      }
+    }
   }
+}
 
-  char *buffer = NULL;
-  size_t bufLen = 0;
-  ssize_t lineLen;
-  vector<Inst_t *> program;
-  vector<Word_t *> words;
+/*
+ * Data accesses of the generated code of each instruction reached by the
+ * forward analysis (without secret), in[i] being the state before it.
+ */
+void analyzeAccesses(vector<Inst_t *> &program, vector<AbsState_t> &in,
+                     vector<bool> &visited,
+                     vector<vector<AbsAccess_t>> &accesses) {
+  analyzeValues(program, 0, in, visited);
+  accesses.assign(program.size(), vector<AbsAccess_t>());
+  for (size_t i = 0; i < program.size(); i++) {
+    if (!visited[i])
+      continue;
+    AbsState_t out = in[i];
+    out.accesses = &accesses[i];
+    program[i]->absExec(out);
+  }
+}
 
-  while ((lineLen = getline(&buffer, &bufLen, stdin)) != -1) {
-    char delim[] = ":";
-    char *type = strtok(buffer, delim);
-    uint32_t addr = strtol(strtok(NULL, delim), NULL, 16);
-    uint32_t inst = strtol(strtok(NULL, delim), NULL, 16);
-    Inst_t *decodedInst;
-    Word_t *inlineWord;
-    switch (type[0]) {
-    case 't':
-      decodedInst = Inst_t::decodeThumb(addr, inst);
-      if (decodedInst != NULL) {
-        program.push_back(decodedInst);
-        // decodedInst->Print();
-        // if (decodedInst->isLDRPC())
-        //   printf("(%x)", decodedInst->targetWord());
-      }
-      // printf("    %s/%d/%d\n", type, addr, inst);
-      break;
-    case 'w':
-      inlineWord = new Word_t(addr, inst);
-      words.push_back(inlineWord);
-      break;
-    case 'a':
-      decodedInst = Inst_t::decodeARM32(addr, inst);
-      if (decodedInst != NULL) {
-        program.push_back(decodedInst);
-        // decodedInst->Print();
+void abstractData(vector<Inst_t *> &program, const uint16_t secretRegs) {
+  const uint32_t count = program.size();
+  if (count == 0)
+    return;
+  vector<vector<uint32_t>> successors = computeSuccessors(program);
+
+  /* forward: abstract values and taint */
+  vector<AbsState_t> in;
+  vector<bool> visited;
+  analyzeValues(program, secretRegs, in, visited);
+
+  /* memory accesses and tainted outputs of each instruction */
+  vector<vector<AbsAccess_t>> accesses(count);
+  vector<bool> tainted(count, false);
+  for (uint32_t i = 0; i < count; i++) {
+    if (!visited[i])
+      continue;
+    Inst_t *inst = program[i];
+    AbsState_t out = in[i];
+    out.accesses = &accesses[i];
+    inst->absExec(out);
+    bool t = out.regsTaint(inst->writtenRegs()) ||
+             (inst->writesFlags() && out.srTaint);
+    for (auto a = accesses[i].begin(); a != accesses[i].end(); ++a)
+      t = t || (a->store && (a->taint || a->address.taint));
+    tainted[i] = t;
+  }
+
+  /* backward: strong liveness from the branches and the tainted values */
+  vector<LiveSet_t> liveIn(count);
+  vector<bool> needed(count, false);
+  vector<bool> neededFlags(count, false);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (uint32_t i = count; i-- > 0;) {
+      if (!visited[i])
+        continue;
+      Inst_t *inst = program[i];
+      LiveSet_t live;
+      for (auto s = successors[i].begin(); s != successors[i].end(); ++s)
+        live.join(liveIn[*s]);
+
+      bool need = inst->isCondBranch() || tainted[i] ||
+                  (inst->writtenRegs() & live.regs) ||
+                  (inst->writesFlags() && live.sr);
+      for (auto a = accesses[i].begin(); a != accesses[i].end(); ++a)
+        if (a->store)
+          need = need || (a->address.known()
+                              ? live.allMem || live.mem.count(a->address.cell())
+                              : live.hasMem());
+      needed[i] = need;
+      neededFlags[i] = live.sr || (tainted[i] && inst->writesFlags());
+
+      /* kill the definitions */
+      live.regs &= ~inst->writtenRegs();
+      if (inst->writesFlags())
+        live.sr = false;
+      for (auto a = accesses[i].begin(); a != accesses[i].end(); ++a)
+        if (a->store && a->whole && a->address.known())
+          live.mem.erase(a->address.cell());
+      /* add the uses */
+      if (need) {
+        live.regs |= inst->readRegs();
+        live.sr = live.sr || inst->isCondBranch();
+        for (auto a = accesses[i].begin(); a != accesses[i].end(); ++a) {
+          if (a->store && a->whole)
+            continue;
+          if (a->address.known())
+            live.mem.insert(a->address.cell());
+          else
+            live.allMem = true;
+        }
       }
-      // printf("    %s/%d/%d\n", type, addr, inst);
-      break;
+      changed = liveIn[i].join(live) || changed;
     }
   }
 
-  for (auto i = program.begin(); i != program.end(); ++i)
-    if ((*i)->isLDRPC()) {
-      for (auto j = words.begin(); j != words.end(); ++j)
-        if ((*i)->targetWord() == (*j)->addr) {
-          (*i)->setImmByPC((*j)->value);
-        }
+  uint32_t abstracted = 0;
+  vector<uint32_t> secretBranches;
+  for (uint32_t i = 0; i < count; i++) {
+    Inst_t *inst = program[i];
+    inst->setAbstracted(!needed[i]);
+    inst->setKeepFlags(neededFlags[i]);
+    if (!needed[i])
+      abstracted++;
+    if (visited[i] && inst->isCondBranch() && in[i].srTaint)
+      secretBranches.push_back(inst->address());
+  }
+  fprintf(stderr, "Data abstraction: %d of %d instructions abstracted\n",
+          abstracted, count);
+  fprintf(stderr, "Secret dependent branches:");
+  for (auto i = secretBranches.begin(); i != secretBranches.end(); ++i)
+    fprintf(stderr, " %x", *i);
+  fprintf(stderr, secretBranches.empty() ? " none\n" : "\n");
+}
+
+/*
+ * The registers of a core are its own: the state keeps the registers that a
+ * program both reads and writes, for any of the programs of the cores.
+ */
+void sliceRegisters(const vector<vector<Inst_t *> *> &programs) {
+  uint16_t stateRegs = 0;
+  for (auto p = programs.begin(); p != programs.end(); ++p) {
+    uint16_t readRegs = 0;
+    uint16_t writtenRegs = 0;
+    for (auto i = (*p)->begin(); i != (*p)->end(); ++i) {
+      if ((*i)->isReachable() && !(*i)->isAbstracted()) {
+        readRegs |= (*i)->readRegs();
+        writtenRegs |= (*i)->writtenRegs();
+      }
     }
+    stateRegs |= readRegs & writtenRegs;
+  }
+  Inst_t::setStateRegs(stateRegs);
+}
 
-  //  genProgData(program);
-  genFuncs(program);
+/*
+ * Cache of the generated model and of the replay, the instruction cache of
+ * Machine_t by default. A unified cache is also accessed by the data
+ * accesses, after the fetch of their instruction.
+ */
+struct CacheConfig_t {
+  enum Policy_t { LRU, FIFO, PLRU };
+  uint32_t sets;
+  uint32_t ways;
+  uint32_t lineSize; // bytes
+  Policy_t policy;   // replacement in a set
+  bool unified;
 
-  uint32_t placeId = 1;
+  static const uint32_t sMaxWays = 16;
+  static const char *const sPolicyNames[3];
+
+  CacheConfig_t()
+      : sets(Machine_t::sCacheLines), ways(1), lineSize(32), policy(LRU),
+        unified(false) {}
+
+  bool isDefault() const {
+    return sets == Machine_t::sCacheLines && ways == 1 && lineSize == 32 &&
+           !unified;
+  }
+};
+
+const char *const CacheConfig_t::sPolicyNames[3] = {"lru", "fifo", "plru"};
+
+/*
+ * <sets>,<ways>,<line size>[,lru|fifo|plru][,unified], the sizes being
+ * powers of two
+ */
+bool parseCacheConfig(const char *spec, CacheConfig_t &cache) {
+  uint32_t values[3];
+  const char *p = spec;
+  for (uint32_t k = 0; k < 3; k++) {
+    char *end;
+    const unsigned long value = strtoul(p, &end, 0);
+    if (end == p || value == 0 || value > (1 << 16) ||
+        (value & (value - 1)) != 0 || (*end != ',' && (k < 2 || *end != '\0')) ||
+        (*end == ',' && end[1] == '\0'))
+      return false;
+    values[k] = value;
+    p = *end == '\0' ? end : end + 1;
+  }
+  if (values[1] > CacheConfig_t::sMaxWays || values[2] < 2)
+    return false;
+  cache.sets = values[0];
+  cache.ways = values[1];
+  cache.lineSize = values[2];
+  cache.policy = CacheConfig_t::LRU;
+  cache.unified = false;
+  while (*p != '\0') {
+    const char *end = strchr(p, ',');
+    const size_t len = end == NULL ? strlen(p) : end - p;
+    uint32_t k = 0;
+    while (k < 3 && (strlen(CacheConfig_t::sPolicyNames[k]) != len ||
+                     strncmp(p, CacheConfig_t::sPolicyNames[k], len) != 0))
+      k++;
+    if (k < 3)
+      cache.policy = (CacheConfig_t::Policy_t)k;
+    else if (len == 7 && strncmp(p, "unified", len) == 0)
+      cache.unified = true;
+    else
+      return false;
+    p = end == NULL ? p + len : end + 1;
+  }
+  return true;
+}
+
+/* memory shared by the cores (--shared), none if size is 0 */
+struct SharedMemory_t {
+  uint32_t start;
+  uint32_t size; // bytes, a multiple of 4
+
+  SharedMemory_t() : start(0), size(0) {}
+};
+
+/* <address>:<size> */
+bool parseSharedMemory(const char *spec, SharedMemory_t &shared) {
+  char *end;
+  const uint32_t start = strtoul(spec, &end, 0);
+  if (end == spec || *end != ':' || start % 4 != 0)
+    return false;
+  const char *sizeSpec = end + 1;
+  const unsigned long size = strtoul(sizeSpec, &end, 0);
+  if (end == sizeSpec || *end != '\0' || size == 0 || size % 4 != 0 ||
+      size > (1 << 16))
+    return false;
+  shared.start = start;
+  shared.size = size;
+  return true;
+}
+
+/* segment of a segmented memory (--segments), an array of mem_t */
+struct Segment_t {
+  string name;
+  uint32_t start; // address of the first word
+  uint32_t end;   // address after the last word
+};
+
+/* <name>=<address>:<size>, the name being a C identifier */
+bool parseSegment(const char *spec, vector<Segment_t> &segments) {
+  const char *equal = strchr(spec, '=');
+  if (equal == NULL || equal == spec || isdigit(spec[0]))
+    return false;
+  for (const char *c = spec; c != equal; c++)
+    if (!isalnum(*c) && *c != '_')
+      return false;
+  char *end;
+  const unsigned long start = strtoul(equal + 1, &end, 0);
+  if (end == equal + 1 || *end != ':')
+    return false;
+  const char *sizeSpec = end + 1;
+  const unsigned long size = strtoul(sizeSpec, &end, 0);
+  if (end == sizeSpec || *end != '\0' || size == 0 || size > (1 << 16) ||
+      start + size > UINT32_MAX)
+    return false;
+  segments.push_back({string(spec, equal - spec), (uint32_t)start & ~3u,
+                      (uint32_t)(start + size + 3) & ~3u});
+  return true;
+}
+
+/*
+ * Segments of a segmented memory: the given ones, the .rodata words from
+ * dataStart, the stack under its initial pointer (dataStart + 100) down to
+ * the lowest stack pointer found by the data flow analysis (the 25 words of
+ * the flat memory when it is not known) and the words at the constant
+ * addresses accessed out of them. Overlapping segments are merged into one,
+ * the segments are sorted by address. The instructions whose data accesses
+ * all have a known address in a single segment are bound to it.
+ */
+vector<Segment_t> computeSegments(const vector<vector<Inst_t *> *> &programs,
+                                  const uint32_t dataStart,
+                                  const uint32_t rodataWords,
+                                  vector<Segment_t> segments) {
+  const uint32_t stackTop = dataStart + 100;
+  uint32_t stackFirst = stackTop;
+  uint32_t stackEnd = stackTop;
+  bool stackKnown = true;
+  set<uint32_t> constWords;
+  /* per instruction, [first, last] word accessed, empty if not known */
+  vector<vector<pair<uint32_t, uint32_t>>> ranges(programs.size());
+  for (size_t p = 0; p < programs.size(); p++) {
+    vector<Inst_t *> &program = *programs[p];
+    vector<AbsState_t> in;
+    vector<bool> visited;
+    vector<vector<AbsAccess_t>> accesses;
+    analyzeAccesses(program, in, visited, accesses);
+    ranges[p].assign(program.size(), make_pair(1u, 0u));
+    for (size_t i = 0; i < program.size(); i++) {
+      if (!visited[i])
+        continue;
+      if (in[i].r[13].kind == AbsValue_t::STACK)
+        stackFirst = min(stackFirst, stackTop + in[i].r[13].value);
+      else
+        stackKnown = false;
+      pair<uint32_t, uint32_t> range(UINT32_MAX, 0);
+      for (auto a = accesses[i].begin(); a != accesses[i].end(); ++a) {
+        if (!a->address.known()) {
+          range = make_pair(1u, 0u);
+          break;
+        }
+        const uint32_t word = (uint32_t)a->address.cell();
+        if (a->address.kind == AbsValue_t::STACK) {
+          const uint32_t address = stackTop + word;
+          stackFirst = min(stackFirst, address);
+          stackEnd = max(stackEnd, address + 4);
+          range = make_pair(min(range.first, address),
+                            max(range.second, address));
+        } else {
+          constWords.insert(word);
+          range = make_pair(min(range.first, word), max(range.second, word));
+        }
+      }
+      if (!accesses[i].empty())
+        ranges[p][i] = range;
+    }
+  }
+  if (!stackKnown)
+    stackFirst = min(stackFirst, dataStart);
+  if (rodataWords > 0)
+    segments.push_back({"ro", dataStart, dataStart + 4 * rodataWords});
+  if (stackFirst < stackEnd)
+    segments.push_back({"stack", stackFirst, stackEnd});
+  for (auto w = constWords.begin(); w != constWords.end(); ++w) {
+    bool covered = false;
+    for (auto g = segments.begin(); g != segments.end() && !covered; ++g)
+      covered = *w >= g->start && *w < g->end;
+    if (covered)
+      continue;
+    char name[16];
+    snprintf(name, sizeof(name), "m%x", *w);
+    segments.push_back({name, *w, *w + 4});
+    while (next(w) != constWords.end() && *next(w) == segments.back().end) {
+      ++w;
+      segments.back().end += 4;
+    }
+  }
+
+  sort(segments.begin(), segments.end(),
+       [](const Segment_t &a, const Segment_t &b) { return a.start < b.start; });
+  vector<Segment_t> merged;
+  for (auto g = segments.begin(); g != segments.end(); ++g) {
+    if (!merged.empty() && g->start < merged.back().end) {
+      merged.back().name += "_" + g->name;
+      merged.back().end = max(merged.back().end, g->end);
+    } else {
+      merged.push_back(*g);
+    }
+  }
+
+  vector<string> names;
+  for (auto g = merged.begin(); g != merged.end(); ++g)
+    names.push_back("_" + g->name);
+  Inst_t::setSegmentNames(names);
+  for (size_t p = 0; p < programs.size(); p++)
+    for (size_t i = 0; i < programs[p]->size(); i++)
+      for (size_t k = 0; k < merged.size(); k++)
+        if (ranges[p][i].first <= ranges[p][i].second &&
+            ranges[p][i].first >= merged[k].start &&
+            ranges[p][i].second < merged[k].end)
+          (*programs[p])[i]->setSegment(k);
+  return merged;
+}
+
+/*
+ * Memory map file: a line "access <cycles>" gives the cycles of a bus
+ * access without wait state (4 by default, the T3 of the hardware model),
+ * the other ones "<name> <address> <size> <wait states> [burst] [stack]"
+ * a region. '#' starts a comment.
+ */
+bool readMemoryMap(const char *fileName, MemoryMap_t &map) {
+  FILE *file = fopen(fileName, "r");
+  if (file == NULL) {
+    perror(fileName);
+    return false;
+  }
+  char *line = NULL;
+  size_t lineSize = 0;
+  uint32_t lineNumber = 0;
+  bool ok = true;
+  while (ok && getline(&line, &lineSize, file) != -1) {
+    lineNumber++;
+    char *comment = strchr(line, '#');
+    if (comment != NULL)
+      *comment = '\0';
+    vector<const char *> fields;
+    for (char *f = strtok(line, " \t\r\n"); f != NULL;
+         f = strtok(NULL, " \t\r\n"))
+      fields.push_back(f);
+    if (fields.empty())
+      continue;
+    char *end;
+    if (strcmp(fields[0], "access") == 0) {
+      const unsigned long cycles =
+          fields.size() == 2 ? strtoul(fields[1], &end, 0) : 0;
+      ok = cycles > 0 && cycles <= 64 && *end == '\0';
+      map.access = cycles;
+      continue;
+    }
+    ok = fields.size() >= 4;
+    Region_t region = {fields[0], 0, 0, 0, false};
+    unsigned long values[3] = {0, 0, 0};
+    for (uint32_t k = 0; ok && k < 3; k++) {
+      values[k] = strtoul(fields[k + 1], &end, 0);
+      ok = end != fields[k + 1] && *end == '\0';
+    }
+    ok = ok && values[1] > 0 && values[0] + values[1] <= (1ULL << 32) &&
+         values[2] <= 64;
+    region.start = values[0];
+    region.end = values[0] + values[1];
+    region.waitStates = values[2];
+    for (size_t k = 4; ok && k < fields.size(); k++) {
+      if (strcmp(fields[k], "burst") == 0)
+        region.burst = true;
+      else if (strcmp(fields[k], "stack") == 0 && map.stackRegion < 0)
+        map.stackRegion = map.regions.size();
+      else
+        ok = false;
+    }
+    map.regions.push_back(region);
+  }
+  if (!ok)
+    fprintf(stderr, "%s:%u: bad memory map line\n", fileName, lineNumber);
+  free(line);
+  fclose(file);
+  return ok;
+}
+
+/*
+ * Region of an address of the model, -1 if none: the stack of the model,
+ * from the end of the .rodata to the initial stack pointer, is the stack
+ * region, whatever the address.
+ */
+int32_t regionOf(const MemoryMap_t &map, const uint32_t address,
+                 const uint32_t stackFirst, const uint32_t stackTop) {
+  if (address >= stackFirst && address < stackTop)
+    return map.stackRegion;
+  for (size_t k = 0; k < map.regions.size(); k++)
+    if (address >= map.regions[k].start && address < map.regions[k].end)
+      return k;
+  return -1;
+}
+
+/*
+ * Bus cycles of the data accesses of each instruction, when the data flow
+ * analysis gives the region of all of them (the literal of LDR PC being in
+ * the program). A stack access goes to the stack region.
+ */
+void classifyAccesses(const vector<vector<Inst_t *> *> &programs,
+                      const MemoryMap_t &map, const uint32_t dataStart,
+                      const uint32_t rodataWords) {
+  const uint32_t stackTop = dataStart + 100;
+  const uint32_t stackFirst = min(dataStart + 4 * rodataWords, stackTop);
+  for (auto p = programs.begin(); p != programs.end(); ++p) {
+    vector<Inst_t *> &program = **p;
+    vector<AbsState_t> in;
+    vector<bool> visited;
+    vector<vector<AbsAccess_t>> accesses;
+    analyzeAccesses(program, in, visited, accesses);
+    for (size_t i = 0; i < program.size(); i++) {
+      Inst_t *inst = program[i];
+      if (!visited[i] || inst->memAccessCount() == 0)
+        continue;
+      /* region and address of each access */
+      vector<pair<int32_t, uint32_t>> words;
+      if (inst->isLDRPC())
+        words.push_back(make_pair(
+            regionOf(map, inst->targetWord(), stackFirst, stackTop),
+            inst->targetWord()));
+      for (auto a = accesses[i].begin(); a != accesses[i].end(); ++a) {
+        if (!a->address.known())
+          break;
+        const uint32_t word = (uint32_t)a->address.cell();
+        if (a->address.kind == AbsValue_t::STACK)
+          words.push_back(make_pair(map.stackRegion, stackTop + word));
+        else
+          words.push_back(
+              make_pair(regionOf(map, word, stackFirst, stackTop), word));
+      }
+      if (words.size() != inst->memAccessCount())
+        continue;
+      uint32_t cycles = 0;
+      for (size_t k = 0; k < words.size(); k++) {
+        const int32_t region = words[k].first;
+        cycles += map.access;
+        if (region < 0)
+          continue;
+        const bool next = k > 0 && words[k - 1].first == region &&
+                          (words[k].second == words[k - 1].second + 4 ||
+                           words[k].second + 4 == words[k - 1].second);
+        if (!(next && map.regions[region].burst))
+          cycles += map.regions[region].waitStates;
+      }
+      if (cycles <= UINT8_MAX)
+        inst->setAccessCycles(cycles);
+    }
+  }
+}
+
+/*
+ * Write memCycles(), the bus cycles of an access whose address is not known
+ * when generating the model.
+ */
+void generateMemoryMapDeclarations(Buffer_t &decl, const MemoryMap_t &map,
+                                   const uint32_t dataStart,
+                                   const uint32_t rodataWords) {
+  const uint32_t stackTop = dataStart + 100;
+  const uint32_t stackFirst = min(dataStart + 4 * rodataWords, stackTop);
+  decl << "// @section memCycles\n";
+  decl << "/* bus cycles of an access, with the wait states of its region */\n";
+  decl << "int memCycles(uint32_t address) {\n";
+  decl << "  int cycles = " << map.access << ";\n";
+  decl << "  if (address >= " << stackFirst << " && address < " << stackTop
+       << ") {\n";
+  decl << "    cycles = "
+       << map.access + (map.stackRegion < 0
+                            ? 0
+                            : map.regions[map.stackRegion].waitStates)
+       << "; // stack\n  }";
+  for (auto r = map.regions.begin(); r != map.regions.end(); ++r) {
+    if (r->waitStates == 0)
+      continue;
+    decl << " else if (address >= " << r->start << " && address < " << r->end
+         << ") {\n";
+    decl << "    cycles = " << map.access + r->waitStates << "; // "
+         << r->name.c_str() << "\n  }";
+  }
+  decl << "\n  return cycles;\n}\n";
+}
+
+/*
+ * Write the cache sections: a cache line holds the tag of an address of the
+ * program (and of the literals, mem_t from dataStart or its segments and
+ * the shared memory for a unified cache) relative to the lowest one, in the
+ * smallest type that fits, 0 being a line not valid. cacheAccess() is
+ * specialized for the configuration, without loop: the ways of the set are
+ * compared one by one, LRU keeps them from the most recently used one, FIFO
+ * keeps the next victim of each set and PLRU the bits of the tree of each
+ * set. The data cache
+ * (dataCache) has the same sections prefixed by d, its lines holding the
+ * tags of the data only.
+ */
+void generateCacheDeclarations(Buffer_t &decl, vector<Inst_t *> &program,
+                               const CacheConfig_t &cache,
+                               const uint32_t dataStart,
+                               const SharedMemory_t &shared,
+                               const vector<Segment_t> &segments,
+                               const bool dataCache = false) {
+  const uint32_t lineShift = __builtin_ctz(cache.lineSize);
+  const uint32_t tagShift = lineShift + __builtin_ctz(cache.sets);
+  const uint32_t ways = cache.ways;
+  const char *name = dataCache ? "dcache" : "cache";
+  uint32_t minTag = UINT32_MAX;
+  uint32_t maxTag = 0;
+  for (auto i = program.begin(); i != program.end() && !dataCache; ++i) {
+    if ((*i)->isReachable()) {
+      minTag = min(minTag, (*i)->address() >> tagShift);
+      maxTag = max(maxTag, (*i)->address() >> tagShift);
+    }
+  }
+  if (cache.unified || dataCache) {
+    for (auto i = program.begin(); i != program.end(); ++i) {
+      if ((*i)->isReachable() && (*i)->isLDRPC()) {
+        minTag = min(minTag, (*i)->targetWord() >> tagShift);
+        maxTag = max(maxTag, (*i)->targetWord() >> tagShift);
+      }
+    }
+    if (segments.empty()) {
+      minTag = min(minTag, dataStart >> tagShift);
+      maxTag = max(maxTag,
+                   (dataStart + 4 * Machine_t::sMemWords - 1) >> tagShift);
+    }
+    for (auto g = segments.begin(); g != segments.end(); ++g) {
+      minTag = min(minTag, g->start >> tagShift);
+      maxTag = max(maxTag, (g->end - 1) >> tagShift);
+    }
+    if (shared.size > 0) {
+      minTag = min(minTag, shared.start >> tagShift);
+      maxTag = max(maxTag, (shared.start + shared.size - 1) >> tagShift);
+    }
+  }
+  if (minTag > maxTag)
+    minTag = maxTag;
+  const uint32_t tagCount = maxTag - minTag + 1;
+  const char *tagType = tagCount < UINT8_MAX    ? "uint8_t"
+                        : tagCount < UINT16_MAX ? "uint16_t"
+                                                : "int";
+  const int64_t tagOffset = (int64_t)minTag - 1;
+  const uint32_t lines = cache.sets * ways;
+  const bool lineArray = ways == 1 || cache.policy == CacheConfig_t::LRU;
+  const char *line = lineArray ? "cache[" : "cache.line[";
+  decl << "// @section " << name << '\n';
+  decl << "// " << cache.sets << (cache.sets == 1 ? " set of " : " sets of ")
+       << ways << (ways == 1 ? " line of " : " lines of ") << cache.lineSize
+       << " bytes";
+  if (ways > 1)
+    decl << ", " << CacheConfig_t::sPolicyNames[cache.policy];
+  decl << (cache.unified ? ", unified\n" : "\n");
+  decl << "// cache line: 0 if not valid, else tag - " << tagOffset << " (the "
+       << (dataCache       ? "data spans "
+           : cache.unified ? "program and the data span "
+                           : "program spans ")
+       << tagCount << " tags)\n";
+  if (lineArray) {
+    decl << "typedef " << tagType << '[' << lines << "] " << name << "_t;\n";
+  } else {
+    decl << "typedef struct {\n";
+    decl << "  " << tagType << '[' << lines << "] line;\n";
+    if (cache.policy == CacheConfig_t::FIFO)
+      decl << "  uint8_t[" << cache.sets << "] next; // next victim\n";
+    else
+      decl << "  " << (ways <= 8 ? "uint8_t[" : "uint16_t[") << cache.sets
+           << "] tree; // bit set: the victim is on the right\n";
+    decl << "} " << name << "_t;\n";
+  }
+
+  const char *initName = dataCache ? "initDCache" : "initCache";
+  decl << "// @section " << initName << '\n';
+  decl << "void " << initName << '(' << name << "_t &cache) {\n";
+  decl << "  for (int i = 0; i < " << lines << "; i++) {\n";
+  decl << "    " << line << "i] = 0; // not valid\n  }\n";
+  if (!lineArray) {
+    const char *field = cache.policy == CacheConfig_t::FIFO ? "next" : "tree";
+    decl << "  for (int i = 0; i < " << cache.sets << "; i++) {\n";
+    decl << "    cache." << field << "[i] = 0;\n  }\n";
+  }
+  decl << "}\n";
+
+  decl << "// @section " << name << "Access\n";
+  decl << "/* Does an access to a cache and return 1 if hit and 0 if miss */\n";
+  decl << "int " << name << "Access(" << name << "_t &cache, int addr) {\n";
+  if (ways == 1) {
+    if (cache.sets == 1)
+      decl << "  int line = 0;\n";
+    else
+      decl << "  int line = (addr >> " << lineShift << ") & "
+           << cache.sets - 1 << ";\n";
+    decl << "  " << tagType << " tag = (addr >> " << tagShift << ") - "
+         << tagOffset << ";\n";
+    decl << "  int result;\n";
+    decl << "  if (cache[line] == tag) {\n";
+    decl << "    result = 1;\n  } else {\n";
+    decl << "    result = 0;\n    cache[line] = tag;\n  }\n";
+    decl << "  return result;\n}\n";
+    return;
+  }
+  if (cache.sets == 1)
+    decl << "  int set = 0;\n";
+  else
+    decl << "  int set = (addr >> " << lineShift << ") & " << cache.sets - 1
+         << ";\n";
+  decl << "  int base = set * " << ways << ";\n";
+  decl << "  " << tagType << " tag = (addr >> " << tagShift << ") - "
+       << tagOffset << ";\n";
+  decl << "  int result = 1;\n";
+  auto lineAt = [&](const uint32_t way) -> Buffer_t & {
+    decl << line << "base";
+    if (way > 0)
+      decl << " + " << way;
+    return decl << ']';
+  };
+  switch (cache.policy) {
+  case CacheConfig_t::LRU: {
+    /* the hit line, or the last one on a miss, moves to the front */
+    decl << "  if (";
+    lineAt(0) << " != tag) {\n";
+    const char *indent = ways == 2 ? "    " : "      ";
+    for (uint32_t way = 1; way < ways; way++) {
+      if (way < ways - 1) {
+        decl << (way == 1 ? "    if (" : " else if (");
+        lineAt(way) << " == tag) {\n";
+      } else {
+        if (ways > 2)
+          decl << " else {\n";
+        decl << indent << "if (";
+        lineAt(way) << " != tag) {\n";
+        decl << indent << "  result = 0;\n" << indent << "}\n";
+      }
+      for (uint32_t k = way; k > 0; k--) {
+        decl << indent;
+        lineAt(k) << " = ";
+        lineAt(k - 1) << ";\n";
+      }
+      if (ways > 2)
+        decl << (way < ways - 1 ? "    }" : "    }\n");
+    }
+    decl << "    ";
+    lineAt(0) << " = tag;\n  }\n";
+    break;
+  }
+  case CacheConfig_t::FIFO:
+    decl << "  if (";
+    for (uint32_t way = 0; way < ways; way++) {
+      if (way > 0)
+        decl << " &&\n      ";
+      lineAt(way) << " != tag";
+    }
+    decl << ") {\n";
+    decl << "    result = 0;\n";
+    decl << "    cache.line[base + cache.next[set]] = tag;\n";
+    decl << "    cache.next[set] = (cache.next[set] + 1) & " << ways - 1
+         << ";\n  }\n";
+    break;
+  case CacheConfig_t::PLRU: {
+    /* the victim follows the bits from the root, node n having the
+       children 2n + 1 and 2n + 2, then the bits point away from the way */
+    const uint32_t levels = __builtin_ctz(ways);
+    decl << "  int way = 0;\n";
+    decl << "  int node = 0;\n";
+    for (uint32_t way = 0; way < ways; way++) {
+      decl << (way == 0 ? "  if (" : " else if (");
+      lineAt(way) << " == tag) {\n";
+      decl << "    way = " << way << ";\n  }";
+    }
+    decl << " else {\n";
+    decl << "    result = 0;\n";
+    for (uint32_t level = 0; level < levels; level++)
+      decl << "    node = 2 * node + 1 + ((cache.tree[set] >> node) & 1);\n";
+    decl << "    way = node - " << ways - 1 << ";\n";
+    decl << "    cache.line[base + way] = tag;\n";
+    decl << "    node = 0;\n  }\n";
+    for (uint32_t level = 0; level < levels; level++) {
+      const uint32_t bit = levels - 1 - level;
+      decl << "  cache.tree[set] = (cache.tree[set] & ~(1 << node)) | ((1 - "
+              "((way >> "
+           << bit << ") & 1)) << node);\n";
+      if (level < levels - 1)
+        decl << "  node = 2 * node + 1 + ((way >> " << bit << ") & 1);\n";
+    }
+    break;
+  }
+  }
+  decl << "  return result;\n}\n";
+}
+
+/*
+ * Write the 16 and 8 bit accesses of declarations.c, on the word accesses
+ * memRead and memWrite followed by suffix, which take the parameters params
+ * (called with args) before the address.
+ */
+void subWordAccesses(Buffer_t &decl, const char *params, const char *args,
+                     const char *suffix) {
+  decl << "uint16_t memRead16" << suffix << '(' << params
+       << ", uint32_t address) {\n";
+  decl << "  int data = memRead" << suffix << '(' << args << ", address);\n";
+  decl << "  int offset = (address & 1) * 16;\n";
+  decl << "  data = (data >> offset) & 0x0000FFFF;\n";
+  decl << "  return data;\n}\n\n";
+  decl << "uint8_t memRead8" << suffix << '(' << params
+       << ", uint32_t address) {\n";
+  decl << "  int data = memRead" << suffix << '(' << args << ", address);\n";
+  decl << "  int offset = (address & 3) * 8;\n";
+  decl << "  data = (data >> offset) & 0x000000FF;\n";
+  decl << "  return data;\n}\n\n";
+  decl << "void memWrite16" << suffix << '(' << params
+       << ", uint32_t address, uint16_t word) {\n";
+  decl << "  uint32_t data = memRead" << suffix << '(' << args
+       << ", address);\n";
+  decl << "  uint32_t offset = (address & 1) * 16;\n";
+  decl << "  uint32_t mask = 0xFFFF0000 >> offset;\n";
+  decl << "  uint32_t word32 = word;\n";
+  decl << "  data = (data & mask) | (word32 << offset);\n";
+  decl << "  memWrite" << suffix << '(' << args << ", address, data);\n}\n\n";
+  decl << "void memWrite8" << suffix << '(' << params
+       << ", uint32_t address, uint8_t b) {\n";
+  decl << "  uint32_t data = memRead" << suffix << '(' << args
+       << ", address);\n";
+  decl << "  uint32_t offset = (address & 3) * 8;\n";
+  decl << "  uint32_t mask = ~(0x000000FF << offset);\n";
+  decl << "  uint32_t word32 = b;\n";
+  decl << "  data = (data & mask) | (word32 << offset);\n";
+  decl << "  memWrite" << suffix << '(' << args << ", address, data);\n}\n";
+}
+
+/*
+ * Write the sections of the state of the cores: the arrays indexed by the
+ * core are sized for the cores, each core being initialized as the single
+ * core of declarations.c with its own memory. A memory shared by the cores
+ * is a single shared_t, the memory accesses in its range going to it: it
+ * holds the constants of .rodata in its range, zero elsewhere. With
+ * a data cache, each core also has its DCache, and with a prefetch buffer
+ * the word in it. A segmented memory has an array per segment, initialized
+ * as the words of the flat memory at the same address.
+ */
+void generateCoreDeclarations(Buffer_t &decl, const uint32_t cores,
+                              const SharedMemory_t &shared,
+                              const bool dataCache, const bool prefetch,
+                              const vector<Segment_t> &segments,
+                              const uint32_t dataStart,
+                              const vector<pair<uint32_t, uint32_t>> &consts) {
+  const uint32_t sharedWords = shared.size / 4;
+  decl << "// @section state\n";
+  if (segments.empty())
+    decl << "typedef struct {\n  int[" << Machine_t::sMemWords
+         << "] a;\n} mem_t;\n\n";
+  else {
+    decl << "typedef struct {\n";
+    for (auto g = segments.begin(); g != segments.end(); ++g)
+      decl << "  int[" << (g->end - g->start) / 4 << "] " << g->name.c_str()
+           << "; // from " << g->start << '\n';
+    decl << "} mem_t;\n\n";
+  }
+  if (sharedWords > 0)
+    decl << "// memory shared by the cores, from " << shared.start << "\n"
+         << "typedef struct {\n  int[" << sharedWords
+         << "] a;\n} shared_t;\n\n";
+  decl << "typedef struct {\n  registers_t regs;\n  cache_t ICache;\n";
+  if (dataCache)
+    decl << "  dcache_t DCache;\n";
+  if (prefetch)
+    decl << "  int fetchBuffer; // word of the prefetch buffer, 0 if empty\n";
+  decl << "} core_t;\n\n";
+  decl << "typedef core_t[" << cores << "] state_t;\n";
+
+  auto zeros = [&]() -> Buffer_t & {
+    decl << '{';
+    for (uint32_t k = 0; k < cores; k++)
+      decl << (k == 0 ? "0" : ", 0");
+    return decl << '}';
+  };
+  decl << "// @section initState\n";
+  decl << "  state_t st;\n";
+  decl << "  mem_t[" << cores << "] mem;\n";
+  if (sharedWords > 0)
+    decl << "  shared_t shared;\n";
+  decl << "  // = 1 if a cache access is a hit\n";
+  decl << "  uint8_t[" << cores << "] isHit = ";
+  zeros() << ";\n";
+  decl << "  // access count of an instruction\n";
+  decl << "  uint8_t[" << cores << "] ac = ";
+  zeros() << ";\n";
+  if (prefetch) {
+    decl << "  // = 1 if the next instruction is in the prefetch buffer\n";
+    decl << "  uint8_t[" << cores << "] buffered = ";
+    zeros() << ";\n";
+  }
+  decl << "  //\n";
+  decl << "  uint8_t[" << cores << "] doFetch = ";
+  zeros() << ";\n";
+
+  decl << "// @section initCores\n";
+  decl << "  for (int k = 0; k < " << cores << "; k++) {\n";
+  decl << "    initCache(st[k].ICache);\n";
+  if (dataCache)
+    decl << "    initDCache(st[k].DCache);\n";
+  if (prefetch)
+    decl << "    st[k].fetchBuffer = 0;\n";
+  decl << "    // initialise registers arbitrarily\n";
+  decl << "    initRegs(st[k].regs);\n";
+  decl << "    // Initialise memory arbitrarily\n";
+  if (segments.empty()) {
+    decl << "    for (int i = 0; i < " << Machine_t::sMemWords << "; i++) {\n";
+    decl << "      mem[k].a[i] = i;\n    }\n";
+  }
+  for (auto g = segments.begin(); g != segments.end(); ++g) {
+    const int32_t first = (int32_t)(g->start - dataStart) / 4;
+    decl << "    for (int i = 0; i < " << (g->end - g->start) / 4
+         << "; i++) {\n";
+    decl << "      mem[k]." << g->name.c_str() << "[i] = i";
+    if (first != 0)
+      decl << (first < 0 ? " - " : " + ") << (first < 0 ? -first : first);
+    decl << ";\n    }\n";
+  }
+  decl << "    initConsts(mem[k]);\n  }\n";
+  if (sharedWords > 0) {
+    decl << "  for (int i = 0; i < " << sharedWords << "; i++) {\n";
+    decl << "    shared.a[i] = 0;\n  }\n";
+    for (auto c = consts.begin(); c != consts.end(); ++c)
+      if (c->first >= shared.start && c->first < shared.start + shared.size)
+        decl << "  shared.a[" << (c->first - shared.start) / 4 << "] = 0x"
+             << Hex_t(c->second) << ";\n";
+  }
+
+  if (sharedWords == 0)
+    return;
+  /* the accesses of the generated functions with the shared memory */
+  const uint32_t end = shared.start + shared.size;
+  decl << "// @section memAccess\n";
+  decl << "uint32_t memRead(mem_t &mem, shared_t &shared, uint32_t address) "
+          "{\n";
+  decl << "  uint32_t data;\n";
+  decl << "  if (address >= " << shared.start << " && address < " << end
+       << ") {\n";
+  decl << "    data = shared.a[(address - " << shared.start << ") / 4];\n";
+  decl << "  } else {\n";
+  decl << "    data = mem.a[(address - dataStart) / 4];\n  }\n";
+  decl << "  return data;\n}\n\n";
+  decl << "void memWrite(mem_t &mem, shared_t &shared, uint32_t address, "
+          "uint32_t data) {\n";
+  decl << "  if (address >= " << shared.start << " && address < " << end
+       << ") {\n";
+  decl << "    shared.a[(address - " << shared.start << ") / 4] = data;\n";
+  decl << "  } else {\n";
+  decl << "    mem.a[(address - dataStart) / 4] = data;\n  }\n}\n\n";
+  subWordAccesses(decl, "mem_t &mem, shared_t &shared", "mem, shared", "");
+}
+
+/*
+ * Write the memory accesses of a segmented memory: each segment has the
+ * accesses of declarations.c suffixed by its name, and the accesses without
+ * suffix decode the address, an address out of the segments being out of
+ * the array of the next segment (or of the last one) as it is out of the
+ * flat memory. initConsts() writes the .rodata words in their segment.
+ */
+void generateSegmentDeclarations(Buffer_t &decl,
+                                 const vector<Segment_t> &segments,
+                                 const vector<pair<uint32_t, uint32_t>> &consts) {
+  decl << "// @section memAccess\n";
+  for (auto g = segments.begin(); g != segments.end(); ++g) {
+    const string suffix = "_" + g->name;
+    decl << "// segment " << g->name.c_str() << ", [" << g->start << ", "
+         << g->end << ")\n";
+    decl << "uint32_t memRead" << suffix.c_str()
+         << "(mem_t &mem, uint32_t address) {\n";
+    decl << "  return mem." << g->name.c_str() << "[(address - " << g->start
+         << ") / 4];\n}\n\n";
+    decl << "void memWrite" << suffix.c_str()
+         << "(mem_t &mem, uint32_t address, uint32_t data) {\n";
+    decl << "  mem." << g->name.c_str() << "[(address - " << g->start
+         << ") / 4] = data;\n}\n\n";
+    subWordAccesses(decl, "mem_t &mem", "mem", suffix.c_str());
+    decl << '\n';
+  }
+  auto decode = [&](const char *call) {
+    for (auto g = segments.begin(); g != segments.end(); ++g) {
+      if (g + 1 == segments.end())
+        decl << (segments.size() == 1 ? "  {\n" : " else {\n");
+      else
+        decl << (g == segments.begin() ? "  if" : " else if")
+             << " (address < " << g->end << ") {\n";
+      decl << "    " << call << g->name.c_str() << "(mem, address"
+           << (call[0] == 'd' ? ");\n  }" : ", data);\n  }");
+    }
+    decl << '\n';
+  };
+  decl << "uint32_t memRead(mem_t &mem, uint32_t address) {\n";
+  decl << "  uint32_t data;\n";
+  decode("data = memRead_");
+  decl << "  return data;\n}\n\n";
+  decl << "void memWrite(mem_t &mem, uint32_t address, uint32_t data) {\n";
+  decode("memWrite_");
+  decl << "}\n\n";
+  subWordAccesses(decl, "mem_t &mem", "mem", "");
+
+  decl << "// @section initConsts\n";
+  decl << "void initConsts(mem_t &mem) {\n";
+  for (auto c = consts.begin(); c != consts.end(); ++c)
+    for (auto g = segments.begin(); g != segments.end(); ++g)
+      if (c->first >= g->start && c->first < g->end)
+        decl << "\tmem." << g->name.c_str() << '[' << (c->first - g->start) / 4
+             << "] = 0x" << Hex_t(c->second) << ";\n";
+  decl << "}\n";
+}
+
+/*
+ * Write the declaration sections that depend on the program. Each section
+ * replaces the region of the same name in the hardware model declarations.
+ * The state types are as narrow as the program allows: the status register
+ * only holds the 4 flags and the cache lines only the tags of the program.
+ * The registers and the memory words stay int since they hold 32 bit values
+ * (addresses, loaded words) and share an array indexed by slot; their
+ * number is narrowed instead (--slice-regs, --segments).
+ */
+void generateDeclarations(const char *fileName, vector<Inst_t *> &program,
+                          const CacheConfig_t &cache,
+                          const CacheConfig_t *dcache,
+                          const uint32_t dataStart, const uint32_t cores,
+                          const SharedMemory_t &shared, const bool prefetch,
+                          const vector<Segment_t> &segments,
+                          const vector<pair<uint32_t, uint32_t>> &consts,
+                          const MemoryMap_t *memoryMap) {
+  const int fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    perror(fileName);
+    exit(1);
+  }
+  Buffer_t decl(fd);
+  const char *regNames[16] = {"r0", "r1", "r2",  "r3",  "r4",  "r5",
+                              "r6", "r7", "r8",  "r9",  "r10", "r11",
+                              "r12", "sp", "lr", "pc"};
+  const uint8_t regCount = Inst_t::stateRegCount();
+
+  decl << "// @section registers\n";
+  decl << "// r[]:";
+  for (uint8_t reg = 0; reg < 16; reg++)
+    if (Inst_t::regSlot(reg) >= 0)
+      decl << ' ' << regNames[reg];
+  decl << "\ntypedef struct {\n";
+  decl << "  int[" << (regCount > 0 ? regCount : 1) << "] r;\n";
+  decl << "  uint8_t sr;\n} registers_t;\n";
+
+  decl << "// @section initRegs\n";
+  decl << "void initRegs(registers_t &regs) {\n";
+  for (uint8_t reg = 0; reg < 16; reg++) {
+    if (Inst_t::regSlot(reg) >= 0) {
+      decl << "  regs.r[" << Inst_t::regSlot(reg) << "] = ";
+      Inst_t::regInitValue(decl, reg);
+      decl << "; // " << regNames[reg] << '\n';
+    }
+  }
+  decl << "  regs.sr = 0;\n}\n";
+
+  generateCacheDeclarations(decl, program, cache, dataStart, shared,
+                            segments);
+  if (dcache != NULL)
+    generateCacheDeclarations(decl, program, *dcache, dataStart, shared,
+                              segments, true);
+  if (cores > 1 || shared.size > 0 || dcache != NULL || prefetch ||
+      !segments.empty())
+    generateCoreDeclarations(decl, cores, shared, dcache != NULL, prefetch,
+                             segments, dataStart, consts);
+  if (!segments.empty())
+    generateSegmentDeclarations(decl, segments, consts);
+  if (memoryMap != NULL)
+    generateMemoryMapDeclarations(decl, *memoryMap, dataStart, consts.size());
+  decl.flush();
+  close(fd);
+}
+
+/*
+ * Write the functions of the instructions to the standard output.
+ */
+void genFuncs(vector<Inst_t *> &program, const unsigned jobs) {
+  Buffer_t out(STDOUT_FILENO);
+  fflush(stdout);
+  parallelEmit(out, program.size(), jobs,
+               [&](Buffer_t &b, size_t k) { program[k]->romeoFunc(b); });
+}
+
+/*
+ * Parse a secret input: a register (r0 to r15, sp or lr) or a memory range
+ * <address>[:<size in bytes>] (4 bytes by default).
+ */
+bool parseSecret(const char *spec, uint16_t &secretRegs) {
+  char *end;
+  if (strcmp(spec, "sp") == 0 || strcmp(spec, "lr") == 0) {
+    secretRegs |= 1 << (spec[0] == 's' ? 13 : 14);
+    return true;
+  }
+  if (spec[0] == 'r') {
+    const long reg = strtol(spec + 1, &end, 10);
+    if (end == spec + 1 || *end != '\0' || reg < 0 || reg > 15)
+      return false;
+    secretRegs |= 1 << reg;
+    return true;
+  }
+  const uint32_t first = strtoul(spec, &end, 0);
+  if (end == spec)
+    return false;
+  uint32_t size = 4;
+  if (*end == ':') {
+    const char *sizeSpec = end + 1;
+    size = strtoul(sizeSpec, &end, 0);
+    if (end == sizeSpec || size == 0)
+      return false;
+  }
+  if (*end != '\0')
+    return false;
+  AbsState_t::sSecretMem.push_back(make_pair(first, first + size - 1));
+  return true;
+}
+
+/*===========================================================================*/
+
+/*
+ * Simulation of the program on the hardware model, without Roméo. The
+ * timing is the one of hardware_models/twoCoresModel3_empty/hardware.xml
+ * for one core: the transition of an instruction fires at the start of its
+ * fetch and accesses the instruction cache. A hit takes iCacheHit cycles, a
+ * miss waits for the bus and refills the line in iCacheRefill cycles. Then
+ * the instruction executes in exec cycles or, if it accesses the memory,
+ * holds the bus for busAccess cycles per access. The fetch of the next
+ * instruction starts with the execution.
+ */
+struct Timing_t {
+  uint32_t iCacheHit;
+  uint32_t iCacheRefill;
+  uint32_t exec;
+  uint32_t busAccess;
+
+  Timing_t() : iCacheHit(1), iCacheRefill(10), exec(1), busAccess(4) {}
+};
+
+/* intervals of the timed transitions, named as in hardware.xml */
+struct Delays_t {
+  Interval_t iCacheHit; // ICacheHit
+  Interval_t refill;    // T14
+  Interval_t exec;      // T4
+  Interval_t access;    // T3, per memory access
+
+  explicit Delays_t(const Timing_t &timing)
+      : iCacheHit({(int32_t)timing.iCacheHit, (int32_t)timing.iCacheHit}),
+        refill({(int32_t)timing.iCacheRefill, (int32_t)timing.iCacheRefill}),
+        exec({(int32_t)timing.exec, (int32_t)timing.exec}),
+        access({(int32_t)timing.busAccess, (int32_t)timing.busAccess}) {}
+
+  static const int32_t sMaxDelay = 1 << 20;
+  static const char *const sNames[4];
+  Interval_t &operator[](const uint32_t k) {
+    return k == 0 ? iCacheHit : k == 1 ? refill : k == 2 ? exec : access;
+  }
+  const Interval_t &operator[](const uint32_t k) const {
+    return k == 0 ? iCacheHit : k == 1 ? refill : k == 2 ? exec : access;
+  }
+};
+
+const char *const Delays_t::sNames[4] = {"ICacheHit", "T14", "T4", "T3"};
+
+bool parseDelay(const char *spec, Delays_t &delays) {
+  const char *value = strchr(spec, '=');
+  if (value == NULL)
+    return false;
+  for (uint32_t k = 0; k < 4; k++) {
+    if ((size_t)(value - spec) != strlen(Delays_t::sNames[k]) ||
+        strncmp(spec, Delays_t::sNames[k], value - spec) != 0)
+      continue;
+    char *end;
+    const long eft = strtol(value + 1, &end, 0);
+    long lft = eft;
+    if (end == value + 1)
+      return false;
+    if (*end == ',') {
+      const char *lftSpec = end + 1;
+      lft = strtol(lftSpec, &end, 0);
+      if (end == lftSpec)
+        return false;
+    }
+    if (*end != '\0' || eft < 0 || lft < eft || lft > Delays_t::sMaxDelay)
+      return false;
+    delays[k] = {(int32_t)eft, (int32_t)lft};
+    return true;
+  }
+  return false;
+}
+
+/*
+ * Firing intervals of ICacheHit, T14, T4 and T3 in the hardware models
+ * (--input), for --zones. The zones follow the fetch, execution and bus
+ * access of simulate(): another timed transition is not modeled and the
+ * model is refused.
+ */
+bool readDelays(const vector<const char *> &inputs, Delays_t &delays) {
+  for (auto input = inputs.begin(); input != inputs.end(); ++input) {
+    Net_t net;
+    if (!readNet(*input, net))
+      return false;
+    for (auto t = net.transitions.begin(); t != net.transitions.end(); ++t) {
+      uint32_t k = 0;
+      while (k < 4 && t->identifier != Delays_t::sNames[k])
+        k++;
+      if (k == 4 && t->eft == 0 && t->lft == 0)
+        continue;
+      if (k == 4) {
+        fprintf(stderr, "%s: %s is timed, the zones only have ICacheHit, "
+                        "T14, T4 and T3\n",
+                *input, t->identifier.c_str());
+        return false;
+      }
+      if (t->lft < t->eft || t->lft > Delays_t::sMaxDelay) {
+        fprintf(stderr, "%s: bad interval [%d,%d] of %s\n", *input, t->eft,
+                t->lft, t->identifier.c_str());
+        return false;
+      }
+      delays[k] = {t->eft, t->lft};
+    }
+  }
+  return true;
+}
+
+/* initial value of a register or of a memory word */
+struct Init_t {
+  bool isReg;
+  uint32_t target; // register number or address
+  int32_t value;
+};
+
+/* values taken by a register or a memory word in a sweep */
+struct Sweep_t {
+  bool isReg;
+  uint32_t target;
+  vector<pair<int64_t, int64_t>> ranges; // [first, last]
+  uint64_t count;
+
+  int32_t value(uint64_t index) const {
+    for (auto i = ranges.begin(); i != ranges.end(); ++i) {
+      const uint64_t size = i->second - i->first + 1;
+      if (index < size)
+        return i->first + index;
+      index -= size;
+    }
+    return 0;
+  }
+};
+
+/* loop bound given with --loop-bound */
+struct LoopBound_t {
+  uint32_t header; // address of the first instruction of the loop
+  uint64_t count;  // executions of the header per entry in the loop
+};
+
+bool parseLoopBound(const char *spec, vector<LoopBound_t> &bounds) {
+  char *end;
+  const uint32_t header = strtoul(spec, &end, 0);
+  if (end == spec || *end != '=')
+    return false;
+  const char *countSpec = end + 1;
+  const uint64_t count = strtoull(countSpec, &end, 0);
+  if (end == countSpec || *end != '\0' || count == 0)
+    return false;
+  bounds.push_back({header, count});
+  return true;
+}
+
+struct Simulation_t {
+  const char *rodata; // objdump -s -j .rodata output
+  vector<Init_t> inits;
+  vector<Sweep_t> sweeps;
+  const char *cases; // one line of initial values per case
+  double clock;      // MHz
+  uint64_t maxCycles;
+  uint32_t cores;   // identical cores of the check
+  vector<LoopBound_t> loopBounds;
+  Delays_t delays;       // zone analysis and replay
+  int64_t deadline;      // cycles, -1 if none
+  const char *trace;     // binary trace of the runs
+  CacheConfig_t cache;   // replay
+  CacheConfig_t dcache;  // model and replay, if dataCache
+  bool dataCache;
+
+  Simulation_t()
+      : rodata(NULL), cases(NULL), clock(48.0), maxCycles(1e9), cores(1),
+        delays(Timing_t()), deadline(-1), trace(NULL), dataCache(false) {}
+};
+
+struct SimResult_t {
+  enum Status_t { STOPPED, FAULT, DEAD_END, TIMEOUT, MERGED };
+  Status_t status;
+  uint32_t address; // stop address, faulty or last instruction
+  uint64_t cycles;  // date at which the place of address is marked
+  uint64_t instructions;
+  uint64_t iCacheMisses;
+};
+
+/*
+ * Set of visited states shared by the threads of the checker, an open
+ * addressing table of 64 bit fingerprints of the states (hash compaction)
+ * filled with compare and swap. The threads probe the table under a shared
+ * lock; once it is 3/4 full, or when the probe sequence of a state is full,
+ * the table is doubled and rehashed under the exclusive lock, so that a
+ * state is never taken for new because the table is full.
+ *
+ * A state whose dates are relative to a date (a clock offset) is also
+ * stored with the range of the dates at which it was reached: its futures
+ * are those of the first visit shifted by the offset, so that it is new
+ * again only when its date widens the range (the times reached from a date
+ * within the range are within those already reached).
+ */
+class VisitedSet_t {
+  struct Slot_t {
+    atomic<uint64_t> fingerprint{0};
+    atomic<uint64_t> first{UINT64_MAX}, last{0}; // dates it was reached at
+  };
+  vector<Slot_t> mSlots;
+  atomic<uint64_t> mSize;
+  uint64_t mLimit;
+  shared_mutex mLock;
+  static const uint32_t sInitialLogSize = 16;
+  static const uint32_t sMaxProbes = 64;
+
+  enum Probe_t { ADDED, FOUND, FULL };
+
+  static Probe_t probe(vector<Slot_t> &slots, const uint64_t fingerprint,
+                       Slot_t *&found) {
+    const size_t mask = slots.size() - 1;
+    for (uint32_t i = 0; i < sMaxProbes; i++) {
+      found = &slots[(fingerprint + i) & mask];
+      uint64_t current = found->fingerprint.load(memory_order_relaxed);
+      if (current == 0 &&
+          found->fingerprint.compare_exchange_strong(current, fingerprint,
+                                                     memory_order_relaxed))
+        return ADDED;
+      if (current == fingerprint)
+        return FOUND;
+    }
+    return FULL;
+  }
+
+  /* returns true if date widens the range of the dates of slot */
+  static bool widen(Slot_t &slot, const uint64_t date) {
+    bool wider = false;
+    uint64_t first = slot.first.load(memory_order_relaxed);
+    while (date < first && !wider)
+      wider = slot.first.compare_exchange_weak(first, date,
+                                               memory_order_relaxed);
+    uint64_t last = slot.last.load(memory_order_relaxed);
+    bool later = false;
+    while (date > last && !later)
+      later = slot.last.compare_exchange_weak(last, date,
+                                              memory_order_relaxed);
+    return wider || later;
+  }
+
+  /* doubles the table unless another thread already grew it */
+  void grow(const size_t capacity) {
+    unique_lock<shared_mutex> lock(mLock);
+    if (mSlots.size() != capacity)
+      return;
+    for (size_t size = 2 * capacity;; size *= 2) {
+      vector<Slot_t> slots(size);
+      bool rehashed = true;
+      for (auto s = mSlots.begin(); rehashed && s != mSlots.end(); ++s) {
+        const uint64_t fingerprint = s->fingerprint.load(memory_order_relaxed);
+        Slot_t *slot;
+        rehashed = fingerprint == 0 || probe(slots, fingerprint, slot) == ADDED;
+        if (rehashed && fingerprint != 0) {
+          slot->first.store(s->first.load(memory_order_relaxed),
+                            memory_order_relaxed);
+          slot->last.store(s->last.load(memory_order_relaxed),
+                           memory_order_relaxed);
+        }
+      }
+      if (rehashed) {
+        mSlots.swap(slots);
+        mLimit = 3 * (uint64_t)size / 4;
+        return;
+      }
+    }
+  }
+
+public:
+  VisitedSet_t()
+      : mSlots((size_t)1 << sInitialLogSize), mSize(0),
+        mLimit(((uint64_t)3 << sInitialLogSize) / 4) {}
+
+  /*
+   * returns true if the state was not in the set or, for a state relative to
+   * date, if it was not reached yet at date
+   */
+  bool insert(uint64_t fingerprint, const uint64_t date = 0) {
+    if (fingerprint == 0)
+      fingerprint = 1; // 0 is an empty slot
+    while (true) {
+      size_t capacity;
+      {
+        shared_lock<shared_mutex> lock(mLock);
+        capacity = mSlots.size();
+        if (mSize.load(memory_order_relaxed) < mLimit) {
+          Slot_t *slot;
+          const Probe_t res = probe(mSlots, fingerprint, slot);
+          if (res == ADDED)
+            mSize++;
+          if (res != FULL)
+            return widen(*slot, date) || res == ADDED;
+        }
+      }
+      grow(capacity);
+    }
+  }
+  uint64_t size() const { return mSize; }
+};
+
+/*
+ * Index of the instruction that follows program[i] when it is executed from
+ * m. The guard is evaluated before the update, as in the net.
+ */
+uint32_t nextIndex(vector<Inst_t *> &program, const uint32_t i,
+                   const Machine_t &m) {
+  Inst_t *inst = program[i];
+  const uint32_t target = inst->targetIdTaken() - 1;
+  if (inst->isCondBranch())
+    return inst->taken(m.sr) ? target : i + 1;
+  if (inst->isUncondBranch() || inst->isFuncCall() || inst->isFuncReturn())
+    return target;
+  return i + 1;
+}
+
+/*
+ * Compact binary trace of the runs of the simulation, replayed by
+ * runReplay() with other latencies and cache geometries. The file starts
+ * with "XTRC" and a version byte, then each run is
+ *   'R', n, n instruction records, status, address
+ * and an instruction record is
+ *   fetch delta, bus accesses (memAccessCount()), k, k data access deltas
+ * where the numbers are LEB128 varints. The fetch delta is the difference
+ * with the address of the previous instruction of the run and a data access
+ * delta the difference with the previous data address of the run, shifted
+ * left once with the low bit set for a write; both are zigzag encoded, so
+ * that sequential code and neighbouring accesses take one byte.
+ */
+static const char sTraceMagic[] = "XTRC";
+static const uint8_t sTraceVersion = 1;
+
+static inline uint64_t zigzag(const int64_t v) {
+  return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+static inline int64_t unzigzag(const uint64_t v) {
+  return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+class TraceWriter_t {
+  Buffer_t mOut;
+  Buffer_t mRun;
+  uint64_t mCount;
+  uint32_t mAddress;
+  uint32_t mData;
+
+  static void varint(Buffer_t &out, uint64_t v) {
+    while (v >= 0x80) {
+      out << (char)(v | 0x80);
+      v >>= 7;
+    }
+    out << (char)v;
+  }
+
+public:
+  explicit TraceWriter_t(const int inFd)
+      : mOut(inFd), mCount(0), mAddress(0), mData(0) {
+    mOut.append(sTraceMagic, 4) << (char)sTraceVersion;
+  }
+
+  void instruction(const uint32_t address, const uint8_t accesses,
+                   const vector<uint64_t> &data) {
+    varint(mRun, zigzag((int64_t)address - mAddress));
+    varint(mRun, accesses);
+    varint(mRun, data.size());
+    for (auto i = data.begin(); i != data.end(); ++i) {
+      const uint32_t dataAddress = *i >> 1;
+      varint(mRun, zigzag((int64_t)dataAddress - mData) << 1 | (*i & 1));
+      mData = dataAddress;
+    }
+    mAddress = address;
+    mCount++;
+  }
+
+  void end(const SimResult_t &res) {
+    mOut << 'R';
+    varint(mOut, mCount);
+    mOut << mRun;
+    varint(mOut, res.status);
+    varint(mOut, res.address);
+    mRun.clear();
+    mCount = 0;
+    mAddress = mData = 0;
+  }
+
+  void flush() { mOut.flush(); }
+};
+
+/*
+ * Simulates the program from m. With a visited set, a run that reaches a
+ * state already visited ends as MERGED. Two runs that join stay together,
+ * so the states are only looked up at the start of the basic blocks. With a
+ * trace, the fetches and the data accesses of the run are appended to it.
+ * The fetch of an instruction waits for its cycles of --mcpu (cycles()), as
+ * its transition in the net.
+ */
+SimResult_t simulate(vector<Inst_t *> &program,
+                     vector<uint32_t> &stopAddresses, Machine_t &m,
+                     const Timing_t &timing, const uint64_t maxCycles,
+                     VisitedSet_t *visited = NULL,
+                     TraceWriter_t *trace = NULL) {
+  SimResult_t res = {SimResult_t::DEAD_END, 0, 0, 0, 0};
+  vector<uint64_t> dataAccesses;
+  if (trace != NULL)
+    m.dataTrace = &dataAccesses;
+  const uint32_t count = program.size();
+  uint64_t marked = 0;   // the current place is marked
+  uint64_t fetch = 0;    // the current instruction fires
+  uint64_t execFree = 0; // end of the previous execution
+  uint64_t busFree = 0;  // end of the previous bus access
+  uint32_t i = 0;
+  bool blockStart = true;
+  while (i < count) {
+    Inst_t *inst = program[i];
+    res.address = inst->address();
+    res.cycles = marked;
+    if (isStopAddress(inst->address(), stopAddresses)) {
+      res.status = SimResult_t::STOPPED;
+      break;
+    }
+    if (fetch > maxCycles) {
+      res.status = SimResult_t::TIMEOUT;
+      break;
+    }
+    if (visited != NULL && blockStart) {
+      uint64_t h = m.hash();
+      h = Machine_t::mix(h, i);
+      h = Machine_t::mix(h, marked);
+      h = Machine_t::mix(h, fetch);
+      h = Machine_t::mix(h, execFree);
+      h = Machine_t::mix(h, busFree);
+      if (!visited->insert(h)) {
+        res.status = SimResult_t::MERGED;
+        break;
+      }
+    }
+    const uint32_t next = nextIndex(program, i, m);
+    blockStart = next != i + 1 || inst->isCondBranch();
+    fetch += inst->cyclesFrom(m.sr);
+    inst->exec(m);
+    const bool hit = m.cacheAccess(inst->address()) == 1;
+    if (m.fault) {
+      res.status = SimResult_t::FAULT;
+      break;
+    }
+    res.instructions++;
+    const uint8_t accesses = inst->memAccessCount();
+    if (trace != NULL) {
+      trace->instruction(inst->address(), accesses, dataAccesses);
+      dataAccesses.clear();
+    }
+
+    uint64_t fetched = fetch + timing.iCacheHit;
+    if (!hit) {
+      fetched = max(fetch, busFree) + timing.iCacheRefill;
+      busFree = fetched;
+      res.iCacheMisses++;
+    }
+    uint64_t start = max(fetched, execFree);
+    if (accesses > 0) {
+      start = max(start, busFree);
+      execFree = busFree = start + (uint64_t)timing.busAccess * accesses;
+    } else {
+      execFree = start + timing.exec;
+    }
+    marked = fetch;
+    fetch = start;
+    i = next;
+  }
+  res.cycles = marked;
+  if (trace != NULL) {
+    m.dataTrace = NULL;
+    trace->end(res);
+  }
+  return res;
+}
+
+/*
+ * Register (r0-r15, sp, lr) or memory address followed by '='. Returns the
+ * value that follows or NULL.
+ */
+const char *parseTarget(const char *spec, bool &isReg, uint32_t &target) {
+  char *end;
+  isReg = true;
+  if (strncmp(spec, "sp=", 3) == 0 || strncmp(spec, "lr=", 3) == 0) {
+    target = spec[0] == 's' ? 13 : 14;
+    end = (char *)spec + 2;
+  } else if (spec[0] == 'r') {
+    const long reg = strtol(spec + 1, &end, 10);
+    if (end == spec + 1 || reg < 0 || reg > 15)
+      return NULL;
+    target = reg;
+  } else {
+    isReg = false;
+    target = strtoul(spec, &end, 0);
+    if (end == spec)
+      return NULL;
+  }
+  return *end == '=' ? end + 1 : NULL;
+}
+
+bool parseInit(const char *spec, vector<Init_t> &inits) {
+  Init_t init;
+  const char *valueSpec = parseTarget(spec, init.isReg, init.target);
+  if (valueSpec == NULL)
+    return false;
+  char *end;
+  init.value = strtoll(valueSpec, &end, 0);
+  if (end == valueSpec || *end != '\0')
+    return false;
+  inits.push_back(init);
+  return true;
+}
+
+/* <target>=<v>|<first>..<last>[,...] */
+bool parseSweep(const char *spec, vector<Sweep_t> &sweeps) {
+  Sweep_t sweep;
+  const char *p = parseTarget(spec, sweep.isReg, sweep.target);
+  if (p == NULL)
+    return false;
+  sweep.count = 0;
+  while (true) {
+    char *end;
+    const int64_t first = strtoll(p, &end, 0);
+    if (end == p)
+      return false;
+    int64_t last = first;
+    if (strncmp(end, "..", 2) == 0) {
+      p = end + 2;
+      last = strtoll(p, &end, 0);
+      if (end == p || last < first)
+        return false;
+    }
+    sweep.ranges.push_back(make_pair(first, last));
+    sweep.count += last - first + 1;
+    if (*end == '\0')
+      break;
+    if (*end != ',')
+      return false;
+    p = end + 1;
+  }
+  sweeps.push_back(sweep);
+  return true;
+}
+
+/*
+ * Initial memory from the .rodata section dumped by objdump -s, as written
+ * by extract_variables.py in initConsts(): dataStart is the address of the
+ * section and the words are little endian.
+ */
+bool readRodata(const char *fileName, uint32_t &dataStart,
+                vector<pair<uint32_t, uint32_t>> &words) {
+  FILE *file = fopen(fileName, "r");
+  if (file == NULL) {
+    perror(fileName);
+    return false;
+  }
+  char *line = NULL;
+  size_t lineSize = 0;
+  bool inSection = false;
+  while (getline(&line, &lineSize, file) != -1) {
+    if (!inSection) {
+      inSection = strstr(line, "Contents of section .rodata:") != NULL;
+      continue;
+    }
+    char *p;
+    const uint32_t address = strtoul(line, &p, 16);
+    if (p == line || *p != ' ')
+      break;
+    if (words.empty())
+      dataStart = address;
+    // up to 4 groups of hex digits, then the characters after two spaces
+    for (uint32_t group = 0; group < 4 && p[0] == ' ' && isxdigit(p[1]);
+         group++) {
+      p++;
+      uint32_t value = 0;
+      for (uint32_t byte = 0; byte < 4 && isxdigit(p[0]) && isxdigit(p[1]);
+           byte++, p += 2) {
+        const char digits[3] = {p[0], p[1], '\0'};
+        value |= strtoul(digits, NULL, 16) << (8 * byte);
+      }
+      words.push_back(make_pair(address + 4 * group, value));
+    }
+  }
+  free(line);
+  fclose(file);
+  return true;
+}
+
+void printSimResult(const SimResult_t &res, const Simulation_t &sim) {
+  switch (res.status) {
+  case SimResult_t::STOPPED:
+    printf("%x: %llu cycles, %.6f ms at %g MHz (%llu instructions, %llu "
+           "I-cache misses)\n",
+           res.address, (unsigned long long)res.cycles,
+           res.cycles / (sim.clock * 1000.0), sim.clock,
+           (unsigned long long)res.instructions,
+           (unsigned long long)res.iCacheMisses);
+    break;
+  case SimResult_t::FAULT:
+    printf("%x: memory access out of mem_t or division by zero after %llu "
+           "cycles\n",
+           res.address, (unsigned long long)res.cycles);
+    break;
+  case SimResult_t::DEAD_END:
+    printf("%x: no successor after %llu cycles\n", res.address,
+           (unsigned long long)res.cycles);
+    break;
+  case SimResult_t::TIMEOUT:
+    printf("%x: no stop address reached after %llu cycles\n", res.address,
+           (unsigned long long)res.cycles);
+    break;
+  case SimResult_t::MERGED:
+    break;
+  }
+}
+
+/*
+ * Inputs of a sweep: the cartesian product of the values of sim.sweeps,
+ * numbered in mixed radix, the first sweep varying the fastest. Returns 0
+ * if there are too many of them.
+ */
+uint64_t sweepInputCount(const Simulation_t &sim) {
+  uint64_t total = 1;
+  for (auto i = sim.sweeps.begin(); i != sim.sweeps.end(); ++i) {
+    if (i->count > UINT64_MAX / total)
+      return 0;
+    total *= i->count;
+  }
+  return total;
+}
+
+void applySweepInput(const Simulation_t &sim, Machine_t &m, uint64_t index) {
+  for (auto i = sim.sweeps.begin(); i != sim.sweeps.end(); ++i) {
+    const int32_t value = i->value(index % i->count);
+    index /= i->count;
+    if (i->isReg)
+      m.r[i->target] = value;
+    else
+      m.memWrite(i->target, value);
+  }
+}
+
+/* prints ", e.g." and the swept inputs of index, nothing without sweep */
+void printSweepInput(const Simulation_t &sim, uint64_t index) {
+  if (!sim.sweeps.empty())
+    printf(", e.g.");
+  for (auto i = sim.sweeps.begin(); i != sim.sweeps.end(); ++i) {
+    const int32_t value = i->value(index % i->count);
+    index /= i->count;
+    if (i->isReg)
+      printf(" r%u=%d", i->target, value);
+    else
+      printf(" %#x=%#x", i->target, value);
+  }
+}
+
+/*
+ * Calls run(thread, index) for each input index in [0, total) with at most
+ * jobs threads. The threads take chunks of inputs until none is left, so
+ * that a thread that meets short runs takes more chunks. Returns the number
+ * of threads.
+ */
+unsigned parallelInputs(const uint64_t total, const unsigned jobs,
+                        const function<void(unsigned, uint64_t)> &run) {
+  const uint64_t chunkSize = 256;
+  const uint64_t chunkCount = (total + chunkSize - 1) / chunkSize;
+  const unsigned threadCount =
+      max(1u, (unsigned)min<uint64_t>(jobs, chunkCount));
+  atomic<uint64_t> nextChunk(0);
+  auto worker = [&](const unsigned t) {
+    uint64_t chunk;
+    while ((chunk = nextChunk++) < chunkCount) {
+      const uint64_t end = min(total, (chunk + 1) * chunkSize);
+      for (uint64_t index = chunk * chunkSize; index < end; index++)
+        run(t, index);
+    }
+  };
+  vector<thread> pool;
+  for (unsigned t = 1; t < threadCount; t++)
+    pool.push_back(thread(worker, t));
+  worker(0);
+  for (auto t = pool.begin(); t != pool.end(); ++t)
+    t->join();
+  return threadCount;
+}
+
+/*
+ * Runs the inputs of the sweep from base and prints the distinct results
+ * ordered by execution time, with the number of inputs giving each one and
+ * the first of them as a witness.
+ */
+int runSweep(vector<Inst_t *> &program, vector<uint32_t> &stopAddresses,
+             const Simulation_t &sim, const Machine_t &base,
+             const unsigned jobs) {
+  const uint64_t total = sweepInputCount(sim);
+  if (total == 0) {
+    fprintf(stderr, "Too many inputs to sweep\n");
+    return 1;
+  }
+
+  /* result (status, cycles, address) to its first input and count */
+  typedef tuple<int, uint64_t, uint32_t> Key_t;
+  struct Outcome_t {
+    uint64_t witness;
+    uint64_t count;
+    SimResult_t result;
+  };
+  typedef map<Key_t, Outcome_t> Outcomes_t;
+  auto record = [](Outcomes_t &outcomes, const Key_t &key,
+                   const Outcome_t &outcome) {
+    auto o = outcomes.find(key);
+    if (o == outcomes.end()) {
+      outcomes[key] = outcome;
+    } else {
+      o->second.count += outcome.count;
+      if (outcome.witness < o->second.witness) {
+        o->second.witness = outcome.witness;
+        o->second.result = outcome.result;
+      }
+    }
+  };
+
+  const Timing_t timing;
+  vector<Outcomes_t> outcomes(max(1u, jobs));
+  const unsigned threadCount =
+      parallelInputs(total, jobs, [&](const unsigned t, const uint64_t index) {
+        Machine_t m = base;
+        applySweepInput(sim, m, index);
+        const SimResult_t res =
+            simulate(program, stopAddresses, m, timing, sim.maxCycles);
+        const Key_t key(res.status, res.cycles, res.address);
+        record(outcomes[t], key, {index, 1, res});
+      });
+  for (unsigned t = 1; t < threadCount; t++)
+    for (auto o = outcomes[t].begin(); o != outcomes[t].end(); ++o)
+      record(outcomes[0], o->first, o->second);
+
+  bool ok = true;
+  for (auto o = outcomes[0].begin(); o != outcomes[0].end(); ++o) {
+    printSimResult(o->second.result, sim);
+    printf("  %llu of %llu inputs",
+           (unsigned long long)o->second.count, (unsigned long long)total);
+    printSweepInput(sim, o->second.witness);
+    printf("\n");
+    ok = ok && o->second.result.status == SimResult_t::STOPPED;
+  }
+  return ok ? 0 : 1;
+}
+
+/*
+ * Identical cores sharing the bus: every core runs the program from the
+ * same initial state, with its own memory (mem[$any]) and instruction
+ * cache. Between two bus accesses a core runs as in simulate(). A core
+ * waiting for the bus takes it as soon as it is free and, when several
+ * cores wait, any of them may take it since the urgent transitions of the
+ * net fire in any order.
+ */
+struct CoreState_t {
+  enum Phase_t { RUN, FETCH, EXEC, DONE };
+  Machine_t m;
+  Phase_t phase;
+  uint32_t i, next; // current and next instruction
+  uint64_t marked, fetch, execFree;
+  uint64_t request;  // date of the pending bus request
+  uint32_t duration; // of the pending bus access
+  SimResult_t result;
+
+  explicit CoreState_t(const Machine_t &inM)
+      : m(inM), phase(RUN), i(0), next(0), marked(0), fetch(0), execFree(0),
+        request(0), duration(0), result({SimResult_t::DEAD_END, 0, 0, 0, 0}) {}
+
+  /*
+   * hash of the state with its dates relative to now, the date at which the
+   * bus is granted next. A core that ended has no future. A waiting core
+   * has its marked date replaced when it is granted the bus and its dates of
+   * request and end of execution only matter from now on.
+   */
+  uint64_t hash(const uint64_t now) const {
+    if (phase == DONE)
+      return Machine_t::mix(0, DONE);
+    uint64_t h = Machine_t::mix(m.hash(), phase);
+    h = Machine_t::mix(h, i);
+    h = Machine_t::mix(h, next);
+    h = Machine_t::mix(h, fetch - now);
+    h = Machine_t::mix(h, max(execFree, now) - now);
+    h = Machine_t::mix(h, max(request, now) - now);
+    return Machine_t::mix(h, duration);
+  }
+
+  /* the pipeline once the instruction is fetched */
+  void execute(const uint64_t fetched, const Timing_t &timing,
+               const uint8_t accesses) {
+    const uint64_t start = max(fetched, execFree);
+    if (accesses > 0) {
+      phase = EXEC;
+      request = start;
+      duration = timing.busAccess * accesses;
+      return;
+    }
+    execFree = start + timing.exec;
+    marked = fetch;
+    fetch = start;
+    i = next;
+    phase = RUN;
+  }
+
+  /* runs up to the next bus request or to the end of the run */
+  void advance(vector<Inst_t *> &program, vector<uint32_t> &stopAddresses,
+               const Timing_t &timing, const uint64_t maxCycles) {
+    while (phase == RUN) {
+      if (i >= program.size()) {
+        result.cycles = marked;
+        phase = DONE;
+        return;
+      }
+      Inst_t *inst = program[i];
+      result.address = inst->address();
+      result.cycles = marked;
+      if (isStopAddress(inst->address(), stopAddresses)) {
+        result.status = SimResult_t::STOPPED;
+        phase = DONE;
+        return;
+      }
+      if (fetch > maxCycles) {
+        result.status = SimResult_t::TIMEOUT;
+        phase = DONE;
+        return;
+      }
+      next = nextIndex(program, i, m);
+      fetch += inst->cyclesFrom(m.sr);
+      inst->exec(m);
+      const bool hit = m.cacheAccess(inst->address()) == 1;
+      if (m.fault) {
+        result.status = SimResult_t::FAULT;
+        phase = DONE;
+        return;
+      }
+      result.instructions++;
+      if (hit) {
+        execute(fetch + timing.iCacheHit, timing, inst->memAccessCount());
+      } else {
+        result.iCacheMisses++;
+        phase = FETCH;
+        request = fetch;
+        duration = timing.iCacheRefill;
+      }
+    }
+  }
+
+  /* the bus is granted at date grant */
+  void granted(vector<Inst_t *> &program, const uint64_t grant,
+               const Timing_t &timing) {
+    if (phase == FETCH) {
+      execute(grant + duration, timing, program[i]->memAccessCount());
+    } else {
+      execFree = grant + duration;
+      marked = fetch;
+      fetch = grant;
+      i = next;
+      phase = RUN;
+    }
+  }
+};
+
+/*
+ * Explores the runs of cores identical cores from m and reports the result
+ * of every core that ends and every run that joins a visited state. Two
+ * states that differ by a permutation of the cores have the same futures
+ * up to the permutation: the states are compared with their cores sorted
+ * (symmetry reduction) and, among waiting cores in the same state, only one
+ * takes the bus. The dates of a state are relative to the date at which the
+ * bus is granted next, so that the states reached at different dates are
+ * merged too (see VisitedSet_t).
+ */
+void exploreCores(vector<Inst_t *> &program, vector<uint32_t> &stopAddresses,
+                  const Machine_t &m, const uint32_t cores,
+                  const Timing_t &timing, const uint64_t maxCycles,
+                  VisitedSet_t &visited,
+                  const function<void(const SimResult_t &)> &report) {
+  struct State_t {
+    vector<CoreState_t> cores;
+    uint64_t busFree;
+  };
+  // the date at which the bus is granted next, after busFree
+  auto nextGrant = [](const State_t &s) {
+    uint64_t grant = UINT64_MAX;
+    for (auto c = s.cores.begin(); c != s.cores.end(); ++c)
+      if (c->phase != CoreState_t::DONE)
+        grant = min(grant, max(c->request, s.busFree));
+    return grant;
+  };
+  auto fingerprint = [](const State_t &s, const uint64_t now) {
+    vector<uint64_t> hashes;
+    for (auto c = s.cores.begin(); c != s.cores.end(); ++c)
+      hashes.push_back(c->hash(now));
+    sort(hashes.begin(), hashes.end());
+    uint64_t h = 0;
+    for (auto k = hashes.begin(); k != hashes.end(); ++k)
+      h = Machine_t::mix(h, *k);
+    return h;
+  };
+  auto ended = [&](const CoreState_t &core) {
+    if (core.phase == CoreState_t::DONE)
+      report(core.result);
+  };
+
+  State_t initial = {vector<CoreState_t>(cores, CoreState_t(m)), 0};
+  for (auto c = initial.cores.begin(); c != initial.cores.end(); ++c) {
+    c->advance(program, stopAddresses, timing, maxCycles);
+    ended(*c);
+  }
+  vector<State_t> stack(1, initial);
+  const uint64_t start = nextGrant(initial);
+  visited.insert(fingerprint(initial, start), start);
+  while (!stack.empty()) {
+    const State_t s = stack.back();
+    stack.pop_back();
+    // the cores waiting when the bus is granted next
+    const uint64_t grant = nextGrant(s);
+    vector<uint64_t> tried;
+    for (uint32_t k = 0; k < s.cores.size(); k++) {
+      const CoreState_t &core = s.cores[k];
+      if (core.phase == CoreState_t::DONE || core.request > grant)
+        continue;
+      const uint64_t h = core.hash(grant);
+      if (find(tried.begin(), tried.end(), h) != tried.end())
+        continue;
+      tried.push_back(h);
+      State_t t = s;
+      CoreState_t &c = t.cores[k];
+      t.busFree = grant + c.duration;
+      c.granted(program, grant, timing);
+      c.advance(program, stopAddresses, timing, maxCycles);
+      ended(c);
+      const uint64_t now = nextGrant(t);
+      if (visited.insert(fingerprint(t, now), now))
+        stack.push_back(t);
+      else
+        report({SimResult_t::MERGED, 0, 0, 0, 0});
+    }
+  }
+}
+
+/*
+ * Explicit state reachability of the stop addresses, EF INSTxxxx[0]>0 in
+ * Roméo, from the initial states given by the inputs of the sweep (a single
+ * one without sweep). A state is the core, the memory, the instruction
+ * cache, the current instruction and the dates of the fetch, execution and
+ * bus of simulate(): since the successor of a state is unique, a run that
+ * reaches a visited state ends as the run that visited it first and is
+ * stopped. With sim.cores identical cores, the states are those of
+ * exploreCores() and the dates are those at which any core reaches a stop
+ * address. Prints the verdict with the minimum and maximum dates at which a
+ * stop address is reached and a witness input for each.
+ */
+int runCheck(vector<Inst_t *> &program, vector<uint32_t> &stopAddresses,
+             const Simulation_t &sim, const Machine_t &base,
+             const unsigned jobs) {
+  const uint64_t total = sweepInputCount(sim);
+  if (total == 0) {
+    fprintf(stderr, "Too many inputs to sweep\n");
+    return 1;
+  }
+  struct Bounds_t {
+    bool reached;
+    uint64_t minCycles, maxCycles;
+    uint64_t minWitness, maxWitness;
+    uint64_t failed, merged;
+  };
+  vector<Bounds_t> bounds(max(1u, jobs), {false, 0, 0, 0, 0, 0, 0});
+  VisitedSet_t visited;
+  const Timing_t timing;
+  auto record = [](Bounds_t &b, const SimResult_t &res, const uint64_t index) {
+    if (res.status == SimResult_t::MERGED) {
+      b.merged++;
+    } else if (res.status != SimResult_t::STOPPED) {
+      b.failed++;
+    } else if (!b.reached) {
+      b = {true, res.cycles, res.cycles, index, index, b.failed, b.merged};
+    } else {
+      if (res.cycles < b.minCycles) {
+        b.minCycles = res.cycles;
+        b.minWitness = index;
+      }
+      if (res.cycles > b.maxCycles) {
+        b.maxCycles = res.cycles;
+        b.maxWitness = index;
+      }
+    }
+  };
+  const unsigned threadCount =
+      parallelInputs(total, jobs, [&](const unsigned t, const uint64_t index) {
+        Machine_t m = base;
+        applySweepInput(sim, m, index);
+        if (sim.cores > 1)
+          exploreCores(program, stopAddresses, m, sim.cores, timing,
+                       sim.maxCycles, visited, [&](const SimResult_t &res) {
+                         record(bounds[t], res, index);
+                       });
+        else
+          record(bounds[t],
+                 simulate(program, stopAddresses, m, timing, sim.maxCycles,
+                          &visited),
+                 index);
+      });
+  Bounds_t &all = bounds[0];
+  for (unsigned t = 1; t < threadCount; t++) {
+    const Bounds_t &b = bounds[t];
+    all.failed += b.failed;
+    all.merged += b.merged;
+    if (!b.reached)
+      continue;
+    if (!all.reached || b.minCycles < all.minCycles ||
+        (b.minCycles == all.minCycles && b.minWitness < all.minWitness)) {
+      all.minCycles = b.minCycles;
+      all.minWitness = b.minWitness;
+    }
+    if (!all.reached || b.maxCycles > all.maxCycles ||
+        (b.maxCycles == all.maxCycles && b.maxWitness < all.maxWitness)) {
+      all.maxCycles = b.maxCycles;
+      all.maxWitness = b.maxWitness;
+    }
+    all.reached = true;
+  }
+
+  printf("EF ");
+  for (auto i = stopAddresses.begin(); i != stopAddresses.end(); ++i)
+    printf("%sINST%x[0]>0", i == stopAddresses.begin() ? "" : " || ", *i);
+  printf(": %s\n", all.reached ? "true" : "false");
+  if (all.reached) {
+    printf("  min %llu cycles, %.6f ms at %g MHz",
+           (unsigned long long)all.minCycles,
+           all.minCycles / (sim.clock * 1000.0), sim.clock);
+    printSweepInput(sim, all.minWitness);
+    printf("\n  max %llu cycles, %.6f ms at %g MHz",
+           (unsigned long long)all.maxCycles,
+           all.maxCycles / (sim.clock * 1000.0), sim.clock);
+    printSweepInput(sim, all.maxWitness);
+    printf("\n");
+  }
+  printf("  %llu initial states, %llu states visited, %llu runs joining a "
+         "visited state,\n  %llu runs ending without reaching a stop "
+         "address\n",
+         (unsigned long long)total, (unsigned long long)visited.size(),
+         (unsigned long long)all.merged, (unsigned long long)all.failed);
+  if (sim.cores > 1)
+    printf("  %u identical cores, the states are compared up to a "
+           "permutation of the cores\n",
+           sim.cores);
+  return all.reached ? 0 : 1;
+}
+
+/*
+ * Zone based timing analysis. The firing intervals [eft, lft] of the timed
+ * transitions of hardware.xml are set with --delay: the dates of the events
+ * of the pipeline are then symbolic and bounded by difference constraints.
+ */
+
+/*
+ * Difference bound matrix over sDim dates: d[i][j] bounds date i - date j,
+ * sInfinity if unbounded. A row is a vector of the compiler (GCC and clang
+ * vector extensions): the closure, the hull and the inclusion work on whole
+ * rows.
+ */
+class Dbm_t {
+public:
+  static const uint32_t sDim = 8;
+  static const int32_t sInfinity = 1 << 29;
+  typedef int32_t Row_t __attribute__((vector_size(sDim * sizeof(int32_t))));
+
+  Row_t d[sDim];
+
+  /* all the dates equal */
+  Dbm_t() {
+    for (uint32_t i = 0; i < sDim; i++)
+      d[i] = Row_t{};
+  }
+
+  /* shortest paths (Floyd-Warshall), one row at a time */
+  void close() {
+    const Row_t inf = Row_t{} + sInfinity;
+    for (uint32_t k = 0; k < sDim; k++) {
+      const Row_t rowK = d[k];
+      for (uint32_t i = 0; i < sDim; i++) {
+        if (d[i][k] >= sInfinity)
+          continue;
+        Row_t sum = rowK + d[i][k];
+        sum = rowK >= inf ? inf : sum;
+        d[i] = sum < d[i] ? sum : d[i];
+      }
+    }
+  }
+  bool empty() const {
+    for (uint32_t i = 0; i < sDim; i++)
+      if (d[i][i] < 0)
+        return true;
+    return false;
+  }
+  bool includedIn(const Dbm_t &other) const {
+    for (uint32_t i = 0; i < sDim; i++) {
+      const Row_t greater = d[i] > other.d[i];
+      for (uint32_t j = 0; j < sDim; j++)
+        if (greater[j])
+          return false;
+    }
+    return true;
+  }
+  /* smallest zone containing both, closed if both are */
+  void join(const Dbm_t &other) {
+    for (uint32_t i = 0; i < sDim; i++)
+      d[i] = other.d[i] > d[i] ? other.d[i] : d[i];
+  }
+
+  /* date x - date y <= c */
+  void constrain(const uint32_t x, const uint32_t y, const int32_t c) {
+    if (c < d[x][y]) {
+      d[x][y] = c;
+      close();
+    }
+  }
+  /* removes the constraints on date x */
+  void release(const uint32_t x) {
+    d[x] = Row_t{} + sInfinity;
+    for (uint32_t i = 0; i < sDim; i++)
+      d[i][x] = sInfinity;
+    d[x][x] = 0;
+  }
+  /* date x = date y + [lo, hi], x != y */
+  void assign(const uint32_t x, const uint32_t y, const int32_t lo,
+              const int32_t hi) {
+    release(x);
+    d[x][y] = hi;
+    d[y][x] = -lo;
+    close();
+  }
+  int32_t lower(const uint32_t x, const uint32_t origin) const {
+    return -d[origin][x];
+  }
+  int32_t upper(const uint32_t x, const uint32_t origin) const {
+    return d[x][origin];
+  }
+};
+
+/* sets of zones without a zone included in another one */
+void addZone(vector<Dbm_t> &zones, const Dbm_t &zone) {
+  if (zone.empty())
+    return;
+  for (auto z = zones.begin(); z != zones.end(); ++z)
+    if (zone.includedIn(*z))
+      return;
+  for (size_t k = 0; k < zones.size();) {
+    if (zones[k].includedIn(zone)) {
+      zones[k] = zones.back();
+      zones.pop_back();
+    } else {
+      k++;
+    }
+  }
+  zones.push_back(zone);
+}
+
+struct ZoneResult_t {
+  SimResult_t::Status_t status;
+  uint32_t address;
+  int32_t bcet, wcet;
+  size_t zones;
+  bool hull; // the zones were joined, the bounds are safe but not tight
+};
+
+const size_t sMaxZones = 256;
+
+/*
+ * Symbolic counterpart of simulate(): the dates of the firing of the current
+ * instruction (F), of the end of the previous execution (E) and bus access
+ * (B) and of the marking of the current place (M) are bounded in each
+ * zone, relative to the origin O. A transition enabled by several places
+ * waits for the last one, so a zone is split by the order of their dates.
+ * Beyond sMaxZones, the zones are replaced by their hull.
+ */
+ZoneResult_t analyzeZones(vector<Inst_t *> &program,
+                          vector<uint32_t> &stopAddresses, Machine_t &m,
+                          const Delays_t &delays, const uint64_t maxCycles) {
+  enum { O, F, E, B, M, T, S };
+  ZoneResult_t res = {SimResult_t::DEAD_END, 0, 0, 0, 1, false};
+  const uint32_t count = program.size();
+  vector<Dbm_t> zones(1);
+
+  /* date dst = max(date a, date b) */
+  auto maxInto = [&](const uint32_t dst, const uint32_t a, const uint32_t b) {
+    vector<Dbm_t> split;
+    for (auto z = zones.begin(); z != zones.end(); ++z) {
+      Dbm_t first = *z;
+      first.constrain(b, a, 0);
+      if (!first.empty() && dst != a)
+        first.assign(dst, a, 0, 0);
+      addZone(split, first);
+      Dbm_t second = *z;
+      second.constrain(a, b, -1);
+      if (!second.empty() && dst != b)
+        second.assign(dst, b, 0, 0);
+      addZone(split, second);
+    }
+    zones.swap(split);
+  };
+  auto delay = [&](const uint32_t dst, const uint32_t src,
+                   const Interval_t &interval, const int32_t times) {
+    for (auto z = zones.begin(); z != zones.end(); ++z)
+      z->assign(dst, src, interval.eft * times, interval.lft * times);
+  };
+  auto bounds = [&](const uint32_t x, int32_t &lo, int32_t &hi) {
+    lo = Dbm_t::sInfinity;
+    hi = 0;
+    for (auto z = zones.begin(); z != zones.end(); ++z) {
+      lo = min(lo, z->lower(x, O));
+      hi = max(hi, z->upper(x, O));
+    }
+  };
+
+  uint32_t i = 0;
+  while (i < count) {
+    Inst_t *inst = program[i];
+    res.address = inst->address();
+    bounds(M, res.bcet, res.wcet);
+    res.zones = zones.size();
+    if (isStopAddress(inst->address(), stopAddresses)) {
+      res.status = SimResult_t::STOPPED;
+      return res;
+    }
+    if (res.wcet >= Dbm_t::sInfinity / 2 || (uint64_t)res.wcet > maxCycles) {
+      res.status = SimResult_t::TIMEOUT;
+      return res;
+    }
+    const uint32_t next = nextIndex(program, i, m);
+    const Interval_t cycles = inst->cycles(inst->taken(m.sr));
+    inst->exec(m);
+    const bool hit = m.cacheAccess(inst->address()) == 1;
+    if (m.fault) {
+      res.status = SimResult_t::FAULT;
+      return res;
+    }
+
+    if (cycles.lft > 0) {
+      delay(T, F, cycles, 1);
+      delay(F, T, {0, 0}, 1);
+    }
+    if (hit) {
+      delay(T, F, delays.iCacheHit, 1);
+    } else {
+      maxInto(S, F, B);
+      delay(T, S, delays.refill, 1);
+      delay(B, T, {0, 0}, 1);
+    }
+    maxInto(S, T, E);
+    const uint8_t accesses = inst->memAccessCount();
+    if (accesses > 0) {
+      maxInto(S, S, B);
+      delay(E, S, delays.access, accesses);
+      delay(B, E, {0, 0}, 1);
+    } else {
+      delay(E, S, delays.exec, 1);
+    }
+    delay(M, F, {0, 0}, 1);
+    delay(F, S, {0, 0}, 1);
+    vector<Dbm_t> released;
+    for (auto z = zones.begin(); z != zones.end(); ++z) {
+      z->release(T);
+      z->release(S);
+      addZone(released, *z);
+    }
+    zones.swap(released);
+    if (zones.size() > sMaxZones) {
+      for (size_t k = 1; k < zones.size(); k++)
+        zones[0].join(zones[k]);
+      zones.resize(1);
+      res.hull = true;
+    }
+    i = next;
+  }
+  bounds(M, res.bcet, res.wcet);
+  res.zones = zones.size();
+  return res;
+}
+
+/*
+ * Prints the BCET and WCET of the program. With a deadline, prints also for
+ * each timed transition the largest lft for which the WCET meets the
+ * deadline, the other intervals being unchanged: the WCET does not decrease
+ * when an lft increases, so it is found by bisection.
+ */
+int runZones(vector<Inst_t *> &program, vector<uint32_t> &stopAddresses,
+             const Simulation_t &sim, const Machine_t &base) {
+  auto analyze = [&](const Delays_t &d) {
+    Machine_t m = base;
+    return analyzeZones(program, stopAddresses, m, d, sim.maxCycles);
+  };
+  const Delays_t &delays = sim.delays;
+  const int64_t deadline = sim.deadline;
+  const ZoneResult_t res = analyze(delays);
+  if (res.status != SimResult_t::STOPPED) {
+    printf("%x: no stop address reached (%s)\n", res.address,
+           res.status == SimResult_t::FAULT ? "memory access out of mem_t"
+           : res.status == SimResult_t::TIMEOUT ? "dates out of the zones"
+                                                : "no successor");
+    return 1;
+  }
+  printf("%x: BCET %d cycles (%.6f ms), WCET %d cycles (%.6f ms) at %g MHz, "
+         "%zu zones%s\n",
+         res.address, res.bcet, res.bcet / (sim.clock * 1000.0), res.wcet,
+         res.wcet / (sim.clock * 1000.0), sim.clock, res.zones,
+         res.hull ? " (joined, the bounds may not be tight)" : "");
+  if (deadline < 0)
+    return 0;
+  printf("  WCET <= %lld cycles, the other intervals unchanged:",
+         (long long)deadline);
+  for (uint32_t k = 0; k < 4; k++) {
+    Delays_t d = delays;
+    int32_t lo = d[k].eft - 1; // WCET <= deadline for lft <= lo
+    int32_t hi = Delays_t::sMaxDelay;
+    while (lo < hi) {
+      const int32_t mid = lo + (hi - lo + 1) / 2;
+      d[k].lft = mid;
+      const ZoneResult_t r = analyze(d);
+      if (r.status == SimResult_t::STOPPED && r.wcet <= deadline)
+        lo = mid;
+      else
+        hi = mid - 1;
+    }
+    printf("%s %s", k == 0 ? "" : ",", Delays_t::sNames[k]);
+    if (lo < delays[k].eft)
+      printf(" never");
+    else if (lo == Delays_t::sMaxDelay)
+      printf(" any lft");
+    else
+      printf(" lft <= %d", lo);
+  }
+  printf("\n");
+  return res.wcet <= deadline ? 0 : 1;
+}
+
+/*===========================================================================*/
+
+/*
+ * Linear program max c.x subject to rows of the form a.x <= rhs or
+ * a.x = rhs, x >= 0. Solved by the simplex method in two phases with
+ * Bland's rule, on a dense tableau: the programs of the static analysis
+ * have a few hundred variables at most.
+ */
+class LinearProgram_t {
+  struct Row_t {
+    vector<double> a;
+    bool equal;
+    double rhs;
+  };
+  vector<Row_t> mRows;
+  size_t mVars;
+
+  static constexpr double sEpsilon = 1e-9;
+
+public:
+  enum Status_t { OPTIMAL, INFEASIBLE, UNBOUNDED };
+
+  explicit LinearProgram_t(const size_t inVars) : mVars(inVars) {}
+
+  void add(const vector<double> &a, const bool equal, const double rhs) {
+    mRows.push_back({a, equal, rhs});
+  }
+
+  Status_t maximize(const vector<double> &c, double &value) const {
+    const size_t m = mRows.size();
+    // columns: variables, one slack or surplus per inequality, artificials
+    size_t cols = mVars;
+    vector<int64_t> slack(m, -1), artificial(m, -1);
+    for (size_t r = 0; r < m; r++)
+      if (!mRows[r].equal)
+        slack[r] = cols++;
+    const size_t firstArtificial = cols;
+    for (size_t r = 0; r < m; r++)
+      if (mRows[r].equal || mRows[r].rhs < 0)
+        artificial[r] = cols++;
+    vector<vector<double>> t(m, vector<double>(cols + 1, 0.0));
+    vector<size_t> basis(m);
+    for (size_t r = 0; r < m; r++) {
+      const double sign = mRows[r].rhs < 0 ? -1.0 : 1.0;
+      for (size_t j = 0; j < mVars; j++)
+        t[r][j] = sign * mRows[r].a[j];
+      if (slack[r] >= 0)
+        t[r][slack[r]] = sign;
+      t[r][cols] = sign * mRows[r].rhs;
+      basis[r] = artificial[r] >= 0 ? artificial[r] : slack[r];
+      if (artificial[r] >= 0)
+        t[r][artificial[r]] = 1.0;
+    }
+
+    // reduced costs of cost for the current basis, columns below limit
+    auto solve = [&](const vector<double> &cost, const size_t limit) {
+      vector<double> z(cols + 1, 0.0);
+      for (size_t j = 0; j < limit; j++)
+        z[j] = cost[j];
+      for (size_t r = 0; r < m; r++)
+        for (size_t j = 0; j <= cols; j++)
+          z[j] -= cost[basis[r]] * t[r][j];
+      for (;;) {
+        size_t enter = limit;
+        for (size_t j = 0; j < limit && enter == limit; j++)
+          if (z[j] > sEpsilon)
+            enter = j;
+        if (enter == limit)
+          return OPTIMAL;
+        size_t leave = m;
+        for (size_t r = 0; r < m; r++) {
+          if (t[r][enter] <= sEpsilon)
+            continue;
+          const double ratio = t[r][cols] / t[r][enter];
+          if (leave == m) {
+            leave = r;
+            continue;
+          }
+          const double best = t[leave][cols] / t[leave][enter];
+          if (ratio < best - sEpsilon ||
+              (ratio < best + sEpsilon && basis[r] < basis[leave]))
+            leave = r;
+        }
+        if (leave == m)
+          return UNBOUNDED;
+        const double pivot = t[leave][enter];
+        for (size_t j = 0; j <= cols; j++)
+          t[leave][j] /= pivot;
+        for (size_t r = 0; r < m; r++) {
+          const double f = t[r][enter];
+          if (r != leave && f != 0.0)
+            for (size_t j = 0; j <= cols; j++)
+              t[r][j] -= f * t[leave][j];
+        }
+        const double f = z[enter];
+        for (size_t j = 0; j <= cols; j++)
+          z[j] -= f * t[leave][j];
+        basis[leave] = enter;
+      }
+    };
+
+    // phase 1: minimize the sum of the artificials
+    vector<double> cost(cols, 0.0);
+    for (size_t j = firstArtificial; j < cols; j++)
+      cost[j] = -1.0;
+    solve(cost, cols);
+    for (size_t r = 0; r < m; r++) {
+      if (basis[r] < firstArtificial)
+        continue;
+      if (t[r][cols] > 1e-7)
+        return INFEASIBLE;
+      // degenerate: drive the artificial out of the basis if possible
+      for (size_t j = 0; j < firstArtificial; j++) {
+        if (fabs(t[r][j]) > sEpsilon) {
+          const double pivot = t[r][j];
+          for (size_t k = 0; k <= cols; k++)
+            t[r][k] /= pivot;
+          for (size_t o = 0; o < m; o++) {
+            const double f = t[o][j];
+            if (o != r && f != 0.0)
+              for (size_t k = 0; k <= cols; k++)
+                t[o][k] -= f * t[r][k];
+          }
+          basis[r] = j;
+          break;
+        }
+      }
+    }
+
+    // phase 2, the artificials never enter again
+    cost.assign(cols, 0.0);
+    for (size_t j = 0; j < mVars; j++)
+      cost[j] = c[j];
+    if (solve(cost, firstArtificial) == UNBOUNDED)
+      return UNBOUNDED;
+    value = 0.0;
+    for (size_t r = 0; r < m; r++)
+      if (basis[r] < mVars)
+        value += c[basis[r]] * t[r][cols];
+    return OPTIMAL;
+  }
+};
+
+/*
+ * Static bounds of the execution time by implicit path enumeration (IPET).
+ * The blocks are those of the translation and the execution counts of
+ * their edges are the variables of a linear program: one unit of flow goes
+ * from the first block to the stop addresses and, for each loop, the back
+ * edges are taken at most count - 1 times per entry. A loop count comes
+ * from --loop-bound or else from the runs of the initial states (--init,
+ * --sweep). The WCET is only a bound when every loop count is given with
+ * --loop-bound, otherwise it is printed as the longest time with the loop
+ * counts observed, which other inputs may exceed.
+ *
+ * The cost of an instruction is the one of simulate() with the timing of a
+ * cache hit or a refill, the cache being classified by a must analysis of
+ * the direct mapped instruction cache. The date of the stop address is
+ * the fetch date of the instruction before it, so it is bounded from above
+ * by the sum of the fetch and execution times of the instructions before,
+ * and from below by the sum of their fetch times (or of the execution time
+ * of the previous instruction in the block, the execution waiting for it).
+ * The bounds of the linear program are safe for the integer one.
+ */
+int runStatic(vector<Inst_t *> &program, vector<uint32_t> &stopAddresses,
+              const Simulation_t &sim, const Machine_t &base,
+              const unsigned jobs) {
+  const uint32_t count = program.size();
+  const Timing_t timing;
+  vector<vector<uint32_t>> successors = computeSuccessors(program);
+  vector<uint32_t> blocks, blockEnds;
+  computeBlocks(program, stopAddresses, blocks, blockEnds);
+  const uint32_t blockCount = blocks.size();
+  if (blockCount == 0) {
+    printf("no instruction before the stop addresses\n");
+    return 1;
+  }
+  vector<int64_t> blockOf(count, -1);
+  for (uint32_t b = 0; b < blockCount; b++)
+    blockOf[blocks[b]] = b;
+  auto isStop = [&](const uint32_t i) {
+    return isStopAddress(program[i]->address(), stopAddresses);
+  };
+
+  /* must analysis of the cache: line -> tag surely there, invalid or
+     unknown, at the entry of each block */
+  const int64_t invalid = -1, unknown = -2;
+  auto lineOf = [](const uint32_t address) { return (address >> 5) & 15; };
+  vector<vector<int64_t>> cacheIn(blockCount);
+  cacheIn[0].assign(Machine_t::sCacheLines, invalid);
+  vector<uint32_t> worklist(1, 0);
+  while (!worklist.empty()) {
+    const uint32_t b = worklist.back();
+    worklist.pop_back();
+    vector<int64_t> cache = cacheIn[b];
+    for (uint32_t i = blocks[b]; i <= blockEnds[b]; i++)
+      cache[lineOf(program[i]->address())] = program[i]->address() >> 9;
+    for (auto s = successors[blockEnds[b]].begin();
+         s != successors[blockEnds[b]].end(); ++s) {
+      if (isStop(*s) || blockOf[*s] < 0)
+        continue;
+      vector<int64_t> &in = cacheIn[blockOf[*s]];
+      bool changed = in.empty();
+      if (in.empty()) {
+        in = cache;
+      } else {
+        for (uint32_t l = 0; l < Machine_t::sCacheLines; l++)
+          if (in[l] != cache[l] && in[l] != unknown) {
+            in[l] = unknown;
+            changed = true;
+          }
+      }
+      if (changed)
+        worklist.push_back(blockOf[*s]);
+    }
+  }
+
+  /* cost of each block up to its last instruction excluded, and of its
+     last instruction */
+  vector<uint64_t> upper(blockCount), lower(blockCount);
+  vector<uint64_t> lastUpper(blockCount), lastLower(blockCount);
+  for (uint32_t b = 0; b < blockCount; b++) {
+    vector<int64_t> cache = cacheIn[b];
+    uint64_t previousExec = 0;
+    upper[b] = lower[b] = 0;
+    for (uint32_t i = blocks[b]; i <= blockEnds[b]; i++) {
+      Inst_t *inst = program[i];
+      const uint32_t line = lineOf(inst->address());
+      const int64_t tag = inst->address() >> 9;
+      const bool hit = cache[line] == tag;
+      const bool miss = cache[line] != tag && cache[line] != unknown;
+      cache[line] = tag;
+      const uint8_t accesses = inst->memAccessCount();
+      const uint64_t exec =
+          accesses > 0 ? (uint64_t)timing.busAccess * accesses : timing.exec;
+      const uint64_t up = (hit ? timing.iCacheHit : timing.iCacheRefill) + exec;
+      const uint64_t low =
+          max<uint64_t>(miss ? timing.iCacheRefill : timing.iCacheHit,
+                        previousExec);
+      previousExec = exec;
+      if (i == blockEnds[b]) {
+        lastUpper[b] = up;
+        lastLower[b] = low;
+      } else {
+        // the cycles of the last instruction depend on the edge taken
+        const Interval_t cycles = inst->cycles(false);
+        upper[b] += up + cycles.lft;
+        lower[b] += low + cycles.eft;
+      }
+    }
+  }
+
+  /* edges of the blocks, the stop being the target blockCount */
+  struct Edge_t {
+    uint32_t from, to;
+    Interval_t cycles; // of the last instruction of from on this edge
+  };
+  vector<Edge_t> edges;
+  for (uint32_t b = 0; b < blockCount; b++) {
+    Inst_t *last = program[blockEnds[b]];
+    for (auto s = successors[blockEnds[b]].begin();
+         s != successors[blockEnds[b]].end(); ++s) {
+      Interval_t cycles = last->cycles(false);
+      if (last->isCondBranch() && *s == last->targetIdTaken() - 1) {
+        const Interval_t taken = last->cycles(true);
+        cycles = {*s == blockEnds[b] + 1 ? cycles.eft : taken.eft, taken.lft};
+      }
+      if (isStop(*s))
+        edges.push_back({b, blockCount, cycles});
+      else if (blockOf[*s] >= 0)
+        edges.push_back({b, (uint32_t)blockOf[*s], cycles});
+    }
+  }
+
+  /* loops: back edges to a dominating block */
+  vector<vector<bool>> dominators(blockCount, vector<bool>(blockCount, true));
+  dominators[0].assign(blockCount, false);
+  dominators[0][0] = true;
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (uint32_t b = 1; b < blockCount; b++) {
+      vector<bool> dom(blockCount, true);
+      for (auto e = edges.begin(); e != edges.end(); ++e)
+        if (e->to == b)
+          for (uint32_t d = 0; d < blockCount; d++)
+            dom[d] = dom[d] && dominators[e->from][d];
+      dom[b] = true;
+      if (dom != dominators[b]) {
+        dominators[b] = dom;
+        changed = true;
+      }
+    }
+  }
+  vector<bool> isHeader(blockCount, false);
+  for (auto e = edges.begin(); e != edges.end(); ++e)
+    if (e->to < blockCount && dominators[e->from][e->to])
+      isHeader[e->to] = true;
+  for (auto l = sim.loopBounds.begin(); l != sim.loopBounds.end(); ++l) {
+    bool header = false;
+    for (uint32_t b = 0; b < blockCount; b++)
+      header = header ||
+               (isHeader[b] && program[blocks[b]]->address() == l->header);
+    if (!header) {
+      fprintf(stderr, "--loop-bound %x=%llu: no loop starts at %x\n",
+              l->header, (unsigned long long)l->count, l->header);
+      return 1;
+    }
+  }
+
+  /* loop counts: annotated or the largest in the runs of the inputs */
+  vector<int64_t> blockContaining(count, -1);
+  for (uint32_t b = 0; b < blockCount; b++)
+    for (uint32_t i = blocks[b]; i <= blockEnds[b]; i++)
+      blockContaining[i] = b;
+  const unsigned threads = max(1u, jobs);
+  vector<vector<uint64_t>> observed(threads, vector<uint64_t>(blockCount, 0));
+  parallelInputs(sweepInputCount(sim), jobs,
+                 [&](const unsigned t, const uint64_t index) {
+                   Machine_t m = base;
+                   applySweepInput(sim, m, index);
+                   vector<uint64_t> current(blockCount, 0);
+                   if (isHeader[0])
+                     current[0] = observed[t][0] = 1;
+                   uint32_t i = 0;
+                   for (uint64_t steps = 0; i < count && !isStop(i) &&
+                                            steps < sim.maxCycles;
+                        steps++) {
+                     const uint32_t next = nextIndex(program, i, m);
+                     program[i]->exec(m);
+                     if (m.fault || next >= count)
+                       break;
+                     const int64_t h = blockOf[next];
+                     if (h >= 0 && isHeader[h] && blockContaining[i] >= 0) {
+                       if (dominators[blockContaining[i]][h])
+                         current[h]++;
+                       else
+                         current[h] = 1;
+                       observed[t][h] = max(observed[t][h], current[h]);
+                     }
+                     i = next;
+                   }
+                 });
+  vector<uint64_t> loopCount(blockCount, 0);
+  vector<bool> annotated(blockCount, false);
+  for (uint32_t b = 0; b < blockCount; b++) {
+    if (!isHeader[b])
+      continue;
+    for (unsigned t = 0; t < threads; t++)
+      loopCount[b] = max(loopCount[b], observed[t][b]);
+    for (auto l = sim.loopBounds.begin(); l != sim.loopBounds.end(); ++l) {
+      if (l->header == program[blocks[b]]->address()) {
+        loopCount[b] = l->count;
+        annotated[b] = true;
+      }
+    }
+  }
+
+  /* the linear program, one variable per edge */
+  LinearProgram_t lp(edges.size());
+  for (uint32_t b = 0; b <= blockCount; b++) {
+    vector<double> a(edges.size(), 0.0);
+    for (size_t e = 0; e < edges.size(); e++) {
+      if (edges[e].to == b)
+        a[e] += 1.0;
+      if (edges[e].from == b)
+        a[e] -= 1.0;
+    }
+    // one unit enters the first block and leaves to the stop addresses
+    lp.add(a, true, b == 0 ? -1.0 : b == blockCount ? 1.0 : 0.0);
+  }
+  for (uint32_t h = 0; h < blockCount; h++) {
+    if (!isHeader[h] || loopCount[h] == 0)
+      continue;
+    vector<double> a(edges.size(), 0.0);
+    for (size_t e = 0; e < edges.size(); e++)
+      if (edges[e].to == h)
+        a[e] = dominators[edges[e].from][h] ? 1.0 : 1.0 - loopCount[h];
+    lp.add(a, false, h == 0 ? loopCount[h] - 1.0 : 0.0);
+  }
+  vector<double> wcetCost(edges.size()), bcetCost(edges.size());
+  for (size_t e = 0; e < edges.size(); e++) {
+    const uint32_t b = edges[e].from;
+    const bool toStop = edges[e].to == blockCount;
+    wcetCost[e] = upper[b] + edges[e].cycles.lft + (toStop ? 0 : lastUpper[b]);
+    bcetCost[e] =
+        -(double)(lower[b] + edges[e].cycles.eft + (toStop ? 0 : lastLower[b]));
+  }
+  double wcet, bcet;
+  const LinearProgram_t::Status_t status = lp.maximize(wcetCost, wcet);
+  if (status == LinearProgram_t::INFEASIBLE ||
+      lp.maximize(bcetCost, bcet) != LinearProgram_t::OPTIMAL) {
+    printf("no stop address reachable\n");
+    return 1;
+  }
+  const uint64_t bcetCycles = ceil(-bcet - 1e-6);
+  bool bounded = true;
+  for (uint32_t h = 0; h < blockCount; h++)
+    bounded = bounded && (!isHeader[h] || annotated[h]);
+  if (status == LinearProgram_t::UNBOUNDED)
+    printf("WCET unbounded");
+  else
+    printf(bounded ? "WCET <= %llu cycles (%.6f ms)"
+                   : "longest time with the observed loop counts %llu cycles "
+                     "(%.6f ms), not a WCET bound",
+           (unsigned long long)floor(wcet + 1e-6),
+           floor(wcet + 1e-6) / (sim.clock * 1000.0));
+  printf(", BCET >= %llu cycles (%.6f ms) at %g MHz\n",
+         (unsigned long long)bcetCycles, bcetCycles / (sim.clock * 1000.0),
+         sim.clock);
+  for (uint32_t h = 0; h < blockCount; h++) {
+    if (!isHeader[h])
+      continue;
+    printf("  loop %x: ", program[blocks[h]]->address());
+    if (loopCount[h] == 0)
+      printf("no bound, not run by the inputs\n");
+    else
+      printf("%llu executions per entry (%s)\n",
+             (unsigned long long)loopCount[h],
+             annotated[h] ? "--loop-bound" : "observed");
+  }
+  if (!bounded && status == LinearProgram_t::OPTIMAL)
+    printf("give --loop-bound for the observed loops to bound the WCET\n");
+  return status == LinearProgram_t::OPTIMAL ? 0 : 1;
+}
+
+/*
+ * Cache of the replay, with the replacement of the cacheAccess() generated
+ * by generateCacheDeclarations(). The lines hold the line number plus one,
+ * 0 being an invalid line. With LRU, the lines of a set are ordered from
+ * the most recently used one.
+ */
+class CacheModel_t {
+  const CacheConfig_t mConfig;
+  const uint32_t mLineShift;
+  vector<uint64_t> mLines;
+  vector<uint32_t> mSetState; // FIFO next victim or PLRU tree
+
+public:
+  explicit CacheModel_t(const CacheConfig_t &inConfig)
+      : mConfig(inConfig), mLineShift(__builtin_ctz(inConfig.lineSize)),
+        mLines((size_t)inConfig.sets * inConfig.ways, 0),
+        mSetState(inConfig.sets, 0) {}
+
+  void reset() {
+    fill(mLines.begin(), mLines.end(), 0);
+    fill(mSetState.begin(), mSetState.end(), 0);
+  }
+
+  /* returns true on a hit */
+  bool access(const uint32_t address) {
+    const uint64_t line = address >> mLineShift;
+    const uint32_t set = line & (mConfig.sets - 1);
+    const uint32_t ways = mConfig.ways;
+    uint64_t *lines = &mLines[(size_t)set * ways];
+    uint32_t way = 0;
+    while (way < ways && lines[way] != line + 1)
+      way++;
+    const bool hit = way < ways;
+    if (ways == 1 || mConfig.policy == CacheConfig_t::LRU) {
+      way = min(way, ways - 1); // a miss evicts the last line
+      memmove(lines + 1, lines, way * sizeof(uint64_t));
+      lines[0] = line + 1;
+    } else if (mConfig.policy == CacheConfig_t::FIFO) {
+      if (!hit) {
+        lines[mSetState[set]] = line + 1;
+        mSetState[set] = (mSetState[set] + 1) & (ways - 1);
+      }
+    } else {
+      uint32_t &tree = mSetState[set];
+      const uint32_t levels = __builtin_ctz(ways);
+      uint32_t node = 0;
+      if (!hit) {
+        for (uint32_t level = 0; level < levels; level++)
+          node = 2 * node + 1 + ((tree >> node) & 1);
+        way = node - (ways - 1);
+        lines[way] = line + 1;
+        node = 0;
+      }
+      for (uint32_t level = 0; level < levels; level++) {
+        const uint32_t bit = (way >> (levels - 1 - level)) & 1;
+        tree = (tree & ~(1 << node)) | ((1 - bit) << node);
+        node = 2 * node + 1 + bit;
+      }
+    }
+    return hit;
+  }
+};
+
+/*
+ * Recomputes the times of the runs of a trace written with --trace, with
+ * the delays of sim.delays and the cache sim.cache: the timing
+ * is the one of simulate() but no instruction is executed. With the data
+ * cache sim.dcache, the loads that hit it are not bus accesses, as in the
+ * generated model. Prints one line per run and returns the exit status.
+ */
+int runReplay(const char *fileName, const Simulation_t &sim) {
+  for (uint32_t k = 0; k < 4; k++)
+    if (sim.delays[k].eft != sim.delays[k].lft) {
+      fprintf(stderr, "The replay takes no firing interval (%s)\n",
+              Delays_t::sNames[k]);
+      return 1;
+    }
+  Timing_t timing;
+  timing.iCacheHit = sim.delays.iCacheHit.eft;
+  timing.iCacheRefill = sim.delays.refill.eft;
+  timing.exec = sim.delays.exec.eft;
+  timing.busAccess = sim.delays.access.eft;
+
+  FILE *file = fopen(fileName, "rb");
+  if (file == NULL) {
+    perror(fileName);
+    return 1;
+  }
+  vector<uint8_t> data;
+  uint8_t block[1 << 16];
+  size_t len;
+  while ((len = fread(block, 1, sizeof(block), file)) > 0)
+    data.insert(data.end(), block, block + len);
+  fclose(file);
+  if (data.size() < 5 || memcmp(data.data(), sTraceMagic, 4) != 0 ||
+      data[4] != sTraceVersion) {
+    fprintf(stderr, "%s: not a trace of this version of extract\n",
+            fileName);
+    return 1;
+  }
+
+  size_t pos = 5;
+  auto varint = [&](uint64_t &v) {
+    v = 0;
+    for (uint32_t shift = 0; shift < 64 && pos < data.size(); shift += 7) {
+      const uint8_t byte = data[pos++];
+      v |= (uint64_t)(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0)
+        return true;
+    }
+    return false;
+  };
+
+  CacheModel_t cache(sim.cache);
+  CacheModel_t dcache(sim.dcache);
+  auto replay = [&](SimResult_t &res) {
+    uint64_t count;
+    if (data[pos++] != 'R' || !varint(count))
+      return false;
+    cache.reset();
+    dcache.reset();
+    res = {SimResult_t::DEAD_END, 0, 0, 0, 0};
+    uint64_t marked = 0;   // the current place is marked
+    uint64_t fetch = 0;    // the current instruction fires
+    uint64_t execFree = 0; // end of the previous execution
+    uint64_t busFree = 0;  // end of the previous bus access
+    uint32_t address = 0;
+    uint32_t dataAddress = 0;
+    for (uint64_t n = 0; n < count; n++) {
+      uint64_t delta, accesses, dataAccesses, access;
+      if (!varint(delta) || !varint(accesses) || !varint(dataAccesses))
+        return false;
+      address += unzigzag(delta);
+      const bool hit = cache.access(address);
+      uint64_t loadHits = 0; // no bus access, with a data cache
+      for (uint64_t k = 0; k < dataAccesses; k++) {
+        if (!varint(access))
+          return false;
+        dataAddress += unzigzag(access >> 1);
+        if (sim.cache.unified)
+          cache.access(dataAddress);
+        else if (sim.dataCache && dcache.access(dataAddress) &&
+                 (access & 1) == 0)
+          loadHits++;
+      }
+      accesses -= min(accesses, loadHits);
+      res.instructions++;
+
+      uint64_t fetched = fetch + timing.iCacheHit;
+      if (!hit) {
+        fetched = max(fetch, busFree) + timing.iCacheRefill;
+        busFree = fetched;
+        res.iCacheMisses++;
+      }
+      uint64_t start = max(fetched, execFree);
+      if (accesses > 0) {
+        start = max(start, busFree);
+        execFree = busFree = start + timing.busAccess * accesses;
+      } else {
+        execFree = start + timing.exec;
+      }
+      marked = fetch;
+      fetch = start;
+    }
+    uint64_t status, stop;
+    if (!varint(status) || !varint(stop) || status > SimResult_t::MERGED)
+      return false;
+    res.status = (SimResult_t::Status_t)status;
+    res.address = stop;
+    res.cycles = marked;
+    return true;
+  };
+
+  bool ok = true;
+  while (pos < data.size()) {
+    SimResult_t res;
+    if (!replay(res)) {
+      fprintf(stderr, "%s: truncated or corrupted trace\n", fileName);
+      return 1;
+    }
+    printSimResult(res, sim);
+    ok = res.status == SimResult_t::STOPPED && ok;
+  }
+  return ok ? 0 : 1;
+}
+
+enum Analysis_t { SIMULATE, CHECK, ZONES, STATIC };
+
+/*
+ * Simulates the program with the initial values of sim, then once per line
+ * of sim.cases (the initial values of the line being applied after those of
+ * sim). Prints one line per run and returns the exit status.
+ */
+int runSimulation(vector<Inst_t *> &program, vector<uint32_t> &stopAddresses,
+                  const Simulation_t &sim, const unsigned jobs,
+                  const Analysis_t analysis) {
+  uint32_t dataStart = Machine_t::sDefaultDataStart;
+  vector<pair<uint32_t, uint32_t>> consts;
+  if (sim.rodata != NULL && !readRodata(sim.rodata, dataStart, consts))
+    return 1;
+  Machine_t base(dataStart);
+  for (auto i = consts.begin(); i != consts.end(); ++i)
+    base.memWrite(i->first, i->second);
+  const Timing_t timing;
+
+  int traceFd = -1;
+  if (sim.trace != NULL) {
+    if (analysis != SIMULATE || !sim.sweeps.empty()) {
+      fprintf(stderr, "Only the runs of --simulate and --cases are traced\n");
+      return 1;
+    }
+    traceFd = open(sim.trace, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (traceFd < 0) {
+      perror(sim.trace);
+      return 1;
+    }
+  }
+  TraceWriter_t trace(traceFd);
+  auto closeTrace = [&]() {
+    if (traceFd < 0)
+      return true;
+    trace.flush();
+    if (close(traceFd) != 0) {
+      perror(sim.trace);
+      return false;
+    }
+    return true;
+  };
+
+  auto run = [&](const vector<Init_t> &inits) {
+    Machine_t m = base;
+    for (auto i = inits.begin(); i != inits.end(); ++i) {
+      if (i->isReg)
+        m.r[i->target] = i->value;
+      else
+        m.memWrite(i->target, i->value);
+    }
+    if (m.fault) {
+      printf("%x: initial value out of mem_t\n", m.faultAddress);
+      return false;
+    }
+    const SimResult_t res =
+        simulate(program, stopAddresses, m, timing, sim.maxCycles, NULL,
+                 traceFd < 0 ? NULL : &trace);
+    printSimResult(res, sim);
+    return res.status == SimResult_t::STOPPED;
+  };
+
+  if (analysis != SIMULATE || !sim.sweeps.empty()) {
+    for (auto i = sim.inits.begin(); i != sim.inits.end(); ++i)
+      if (i->isReg)
+        base.r[i->target] = i->value;
+      else
+        base.memWrite(i->target, i->value);
+    for (auto i = sim.sweeps.begin(); i != sim.sweeps.end(); ++i)
+      if (!i->isReg)
+        base.memWrite(i->target, 0);
+    if (base.fault) {
+      printf("%x: initial value out of mem_t\n", base.faultAddress);
+      return 1;
+    }
+    if (analysis == ZONES) {
+      if (!sim.sweeps.empty() || sim.cases != NULL) {
+        fprintf(stderr, "The zone analysis takes no --sweep or --cases\n");
+        return 1;
+      }
+      return runZones(program, stopAddresses, sim, base);
+    }
+    if (analysis == STATIC)
+      return runStatic(program, stopAddresses, sim, base, jobs);
+    if (analysis == CHECK)
+      return runCheck(program, stopAddresses, sim, base, jobs);
+    return runSweep(program, stopAddresses, sim, base, jobs);
+  }
+  if (sim.cases == NULL) {
+    const bool ok = run(sim.inits);
+    return closeTrace() && ok ? 0 : 1;
+  }
+
+  FILE *file = fopen(sim.cases, "r");
+  if (file == NULL) {
+    perror(sim.cases);
+    return 1;
+  }
+  bool ok = true;
+  char *line = NULL;
+  size_t lineSize = 0;
+  while (getline(&line, &lineSize, file) != -1) {
+    if (line[0] == '#' || line[strspn(line, " \t\n")] == '\0')
+      continue;
+    vector<Init_t> inits = sim.inits;
+    for (char *spec = strtok(line, " \t\n"); spec != NULL;
+         spec = strtok(NULL, " \t\n")) {
+      if (!parseInit(spec, inits)) {
+        fprintf(stderr, "Bad initial value in %s: %s\n", sim.cases, spec);
+        exit(1);
+      }
+    }
+    ok = run(inits) && ok;
+  }
+  free(line);
+  fclose(file);
+  return closeTrace() && ok ? 0 : 1;
+}
+
+/*===========================================================================*/
+
+/*
+ * Ahead of time translation of the program into a standalone C++ simulator,
+ * with the semantics and the timing of simulate(). Each basic block becomes
+ * a function running the generated code of its instructions
+ * (romeoFuncContent()) on a local copy of the registers, the fetch, cache
+ * and bus timing being inlined after each instruction. An instruction that
+ * shares its cache line with the previous one of the block is a hit and
+ * does not access the cache. The initial memory from the .rodata dump is
+ * compiled in. The file is compiled with g++ -O2 -fwrapv (int arithmetic
+ * wraps as in Roméo) into an executable, or into a library with
+ * -DSIMULATOR_LIBRARY.
+ */
+const char *sTranslationHeader =
+    "static const int32_t Nmask = 1 << 0;\n"
+    "static const int32_t Zmask = 1 << 1;\n"
+    "static const int32_t Cmask = 1 << 2;\n"
+    "static const int32_t Vmask = 1 << 3;\n"
+    "static const int32_t valid = INT32_MIN;\n"
+    "static const int32_t tagMask = INT32_MAX;\n\n"
+    "enum { STOP = -1, DEAD_END = -2, FAULT = -3, TIMEOUT = -4 };\n\n"
+    "struct registers_t {\n  int32_t r[16];\n  int32_t sr;\n};\n\n"
+    "struct core_t {\n  registers_t regs;\n};\n\n"
+    "struct mem_t {\n  int32_t a[30];\n  bool fault;\n};\n\n"
+    "struct machine_t {\n"
+    "  core_t core;\n"
+    "  mem_t mem;\n"
+    "  int32_t ICache[16];\n"
+    "  uint64_t marked, fetch, execFree, busFree;\n"
+    "  uint64_t instructions, iCacheMisses;\n"
+    "  uint32_t address; // stop address, faulty or last instruction\n"
+    "};\n\n"
+    "static inline uint64_t max(uint64_t a, uint64_t b) {\n"
+    "  return a > b ? a : b;\n"
+    "}\n\n"
+    "static inline void updateSR(registers_t &regs, uint64_t val, "
+    "uint32_t op1,\n"
+    "                            uint32_t op2) {\n"
+    "  regs.sr = val == 0 ? regs.sr | Zmask : regs.sr & ~Zmask;\n"
+    "  regs.sr = ((val >> 31) & 1) ? regs.sr | Nmask : regs.sr & ~Nmask;\n"
+    "  regs.sr = ((val >> 32) & 1) ? regs.sr | Cmask : regs.sr & ~Cmask;\n"
+    "  regs.sr = regs.sr & ~Vmask;\n"
+    "  if ((op1 >> 31) & (1 == (op2 >> 31)) & 1)\n"
+    "    if ((op1 >> 31) & (1 != (val >> 31)) & 1)\n"
+    "      regs.sr = regs.sr | Vmask;\n"
+    "}\n\n"
+    "static inline int cacheAccess(int32_t *cache, int32_t addr) {\n"
+    "  int32_t line = (addr >> 5) & 15;\n"
+    "  int32_t tag = (addr >> 9) & tagMask;\n"
+    "  if ((cache[line] & valid) != 0 && (cache[line] & tagMask) == tag)\n"
+    "    return 1;\n"
+    "  cache[line] = valid | tag;\n"
+    "  return 0;\n"
+    "}\n\n"
+    "static inline uint32_t memRead(mem_t &mem, uint32_t address) {\n"
+    "  uint32_t index = (address - dataStart) / 4;\n"
+    "  if (index >= 30) {\n"
+    "    mem.fault = true;\n"
+    "    return 0;\n"
+    "  }\n"
+    "  return mem.a[index];\n"
+    "}\n\n"
+    "static inline void memWrite(mem_t &mem, uint32_t address, "
+    "uint32_t data) {\n"
+    "  uint32_t index = (address - dataStart) / 4;\n"
+    "  if (index >= 30)\n"
+    "    mem.fault = true;\n"
+    "  else\n"
+    "    mem.a[index] = data;\n"
+    "}\n\n"
+    "static inline uint16_t memRead16(mem_t &mem, uint32_t address) {\n"
+    "  int32_t data = memRead(mem, address);\n"
+    "  return (data >> ((address & 1) * 16)) & 0x0000FFFF;\n"
+    "}\n\n"
+    "static inline uint8_t memRead8(mem_t &mem, uint32_t address) {\n"
+    "  int32_t data = memRead(mem, address);\n"
+    "  return (data >> ((address & 3) * 8)) & 0x000000FF;\n"
+    "}\n\n"
+    "static inline void memWrite16(mem_t &mem, uint32_t address, "
+    "uint16_t word) {\n"
+    "  uint32_t offset = (address & 1) * 16;\n"
+    "  uint32_t mask = 0xFFFF0000 >> offset;\n"
+    "  memWrite(mem, address,\n"
+    "           (memRead(mem, address) & mask) | ((uint32_t)word << offset));\n"
+    "}\n\n"
+    "static inline void memWrite8(mem_t &mem, uint32_t address, uint8_t b) "
+    "{\n"
+    "  uint32_t offset = (address & 3) * 8;\n"
+    "  uint32_t mask = ~(0x000000FF << offset);\n"
+    "  memWrite(mem, address,\n"
+    "           (memRead(mem, address) & mask) | ((uint32_t)b << offset));\n"
+    "}\n\n";
+
+const char *sTranslationMain =
+    "/* initial state of declarations.c with the .rodata words */\n"
+    "void initMachine(machine_t &m) {\n"
+    "  memset(&m, 0, sizeof(m));\n"
+    "  for (int i = 0; i < 16; i++)\n"
+    "    m.core.regs.r[i] = i;\n"
+    "  m.core.regs.r[13] = dataStart + 100;\n"
+    "  for (int i = 0; i < 30; i++)\n"
+    "    m.mem.a[i] = i;\n"
+    "  initConsts(m.mem);\n"
+    "}\n\n"
+    "/* runs from m, returns STOP, DEAD_END, FAULT or TIMEOUT */\n"
+    "int run(machine_t &m, uint64_t maxCycles) {\n"
+    "  int block = firstBlock;\n"
+    "  m.address = firstAddress;\n"
+    "  while (block >= 0) {\n"
+    "    if (m.fetch > maxCycles) {\n"
+    "      m.address = blockAddress[block];\n"
+    "      return TIMEOUT;\n"
+    "    }\n"
+    "    block = blocks[block](m);\n"
+    "  }\n"
+    "  return block;\n"
+    "}\n\n"
+    "#ifndef SIMULATOR_LIBRARY\n"
+    "static bool parseInit(const char *spec, machine_t &m) {\n"
+    "  char *end;\n"
+    "  int32_t *target;\n"
+    "  if (strncmp(spec, \"sp=\", 3) == 0 || strncmp(spec, \"lr=\", 3) == 0) "
+    "{\n"
+    "    target = &m.core.regs.r[spec[0] == 's' ? 13 : 14];\n"
+    "    end = (char *)spec + 2;\n"
+    "  } else if (spec[0] == 'r') {\n"
+    "    long reg = strtol(spec + 1, &end, 10);\n"
+    "    if (end == spec + 1 || reg < 0 || reg > 15)\n"
+    "      return false;\n"
+    "    target = &m.core.regs.r[reg];\n"
+    "  } else {\n"
+    "    uint32_t index = (strtoul(spec, &end, 0) - dataStart) / 4;\n"
+    "    if (end == spec || index >= 30)\n"
+    "      return false;\n"
+    "    target = &m.mem.a[index];\n"
+    "  }\n"
+    "  if (*end != '=')\n"
+    "    return false;\n"
+    "  const char *valueSpec = end + 1;\n"
+    "  *target = strtoll(valueSpec, &end, 0);\n"
+    "  return end != valueSpec && *end == '\\0';\n"
+    "}\n\n"
+    "static bool simulate(const machine_t &initial) {\n"
+    "  machine_t m = initial;\n"
+    "  unsigned long long cycles;\n"
+    "  switch (run(m, maxCycles)) {\n"
+    "  case STOP:\n"
+    "    cycles = m.marked;\n"
+    "    printf(\"%x: %llu cycles, %.6f ms at %g MHz (%llu instructions, "
+    "%llu \"\n"
+    "           \"I-cache misses)\\n\",\n"
+    "           m.address, cycles, cycles / (clockMHz * 1000.0), clockMHz,\n"
+    "           (unsigned long long)m.instructions,\n"
+    "           (unsigned long long)m.iCacheMisses);\n"
+    "    return true;\n"
+    "  case FAULT:\n"
+    "    printf(\"%x: memory access out of mem_t or division by zero after "
+    "%llu \"\n"
+    "           \"cycles\\n\",\n"
+    "           m.address, (unsigned long long)m.marked);\n"
+    "    break;\n"
+    "  case DEAD_END:\n"
+    "    printf(\"%x: no successor after %llu cycles\\n\", m.address,\n"
+    "           (unsigned long long)m.marked);\n"
+    "    break;\n"
+    "  case TIMEOUT:\n"
+    "    printf(\"%x: no stop address reached after %llu cycles\\n\", "
+    "m.address,\n"
+    "           (unsigned long long)m.marked);\n"
+    "    break;\n"
+    "  }\n"
+    "  return false;\n"
+    "}\n\n"
+    "/*\n"
+    " * usage: simulator [--cases <file>] [<x>=<v> ...]\n"
+    " * runs once with the initial values of the arguments (registers r0-r15, "
+    "sp,\n"
+    " * lr or memory words), or once per line of initial values of the "
+    "cases.\n"
+    " */\n"
+    "int main(int argc, char *argv[]) {\n"
+    "  machine_t initial;\n"
+    "  initMachine(initial);\n"
+    "  const char *cases = NULL;\n"
+    "  for (int i = 1; i < argc; i++) {\n"
+    "    if (strcmp(argv[i], \"--cases\") == 0 && i + 1 < argc) {\n"
+    "      cases = argv[++i];\n"
+    "    } else if (!parseInit(argv[i], initial)) {\n"
+    "      fprintf(stderr, \"Bad initial value: %s\\n\", argv[i]);\n"
+    "      return 1;\n"
+    "    }\n"
+    "  }\n"
+    "  if (cases == NULL)\n"
+    "    return simulate(initial) ? 0 : 1;\n"
+    "  FILE *file = fopen(cases, \"r\");\n"
+    "  if (file == NULL) {\n"
+    "    perror(cases);\n"
+    "    return 1;\n"
+    "  }\n"
+    "  bool ok = true;\n"
+    "  char *line = NULL;\n"
+    "  size_t lineSize = 0;\n"
+    "  while (getline(&line, &lineSize, file) != -1) {\n"
+    "    if (line[0] == '#' || line[strspn(line, \" \\t\\n\")] == '\\0')\n"
+    "      continue;\n"
+    "    machine_t m = initial;\n"
+    "    for (char *spec = strtok(line, \" \\t\\n\"); spec != NULL;\n"
+    "         spec = strtok(NULL, \" \\t\\n\")) {\n"
+    "      if (!parseInit(spec, m)) {\n"
+    "        fprintf(stderr, \"Bad initial value in %s: %s\\n\", cases, "
+    "spec);\n"
+    "        return 1;\n"
+    "      }\n"
+    "    }\n"
+    "    ok = simulate(m) && ok;\n"
+    "  }\n"
+    "  free(line);\n"
+    "  fclose(file);\n"
+    "  return ok ? 0 : 1;\n"
+    "}\n"
+    "#endif\n";
+
+/* guard() in C, for the translated code */
+void cGuard(Buffer_t &out, const char *guard) {
+  const char *const from[] = {"st[$any].regs.sr", "#eqeq", "#noteq"};
+  const char *const to[] = {"core.regs.sr", "==", "!="};
+  while (*guard != '\0') {
+    bool replaced = false;
+    for (uint32_t k = 0; k < 3 && !replaced; k++) {
+      const size_t len = strlen(from[k]);
+      if (strncmp(guard, from[k], len) == 0) {
+        out << to[k];
+        guard += len;
+        replaced = true;
+      }
+    }
+    if (!replaced)
+      out << *guard++;
+  }
+}
+
+void generateTranslation(vector<Inst_t *> &program,
+                         vector<uint32_t> &stopAddresses,
+                         const Simulation_t &sim, const char *fileName,
+                         const unsigned jobs) {
+  uint32_t dataStart = Machine_t::sDefaultDataStart;
+  vector<pair<uint32_t, uint32_t>> consts;
+  if (sim.rodata != NULL && !readRodata(sim.rodata, dataStart, consts))
+    exit(1);
+  vector<uint32_t> blocks, blockEnds;
+  computeBlocks(program, stopAddresses, blocks, blockEnds);
+  const uint32_t count = program.size();
+  vector<int32_t> blockOf(count, -1);
+  for (uint32_t b = 0; b < blocks.size(); b++)
+    blockOf[blocks[b]] = b;
+  const Timing_t timing;
+
+  const int fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    perror(fileName);
+    exit(1);
+  }
+  Buffer_t out(fd);
+  out << "// Simulator generated by extract --translate, compile with\n"
+         "// g++ -O2 -fwrapv [-DSIMULATOR_LIBRARY -c]\n";
+  out << "#include <stdint.h>\n#include <stdio.h>\n#include <stdlib.h>\n"
+         "#include <string.h>\n\n";
+  out << "static const uint32_t dataStart = " << dataStart << ";\n";
+  out << sTranslationHeader;
+  out << "void initConsts(mem_t &mem) {\n";
+  for (auto i = consts.begin(); i != consts.end(); ++i)
+    out << "  memWrite(mem, " << i->first << ", " << i->second << ");\n";
+  out << "}\n\n";
+
+  /* successor of instruction i to the index of target */
+  auto genNext = [&](Buffer_t &out, const uint32_t i, const uint32_t target) {
+    if (target >= count)
+      out << "{ m.address = " << program[i]->address()
+          << "; next = DEAD_END; }";
+    else if (blockOf[target] < 0)
+      out << "{ m.address = " << program[target]->address()
+          << "; next = STOP; }";
+    else
+      out << "next = " << blockOf[target] << ';';
+  };
+
+  parallelEmit(out, blocks.size(), jobs, [&](Buffer_t &out, size_t b) {
+    out << "/* " << Hex_t(program[blocks[b]]->address()) << " - "
+        << Hex_t(program[blockEnds[b]]->address()) << " */\n";
+    Buffer_t body;
+    bool accessesMem = false;
+    uint32_t line = UINT32_MAX;
+    for (uint32_t i = blocks[b]; i <= blockEnds[b]; i++) {
+      Inst_t *inst = program[i];
+      const uint32_t target = inst->targetIdTaken() - 1;
+      body << "  // ";
+      inst->Print(body);
+      body << '\n';
+      if (i == blockEnds[b]) {
+        body << "  ";
+        if (inst->isCondBranch()) {
+          const uint32_t cycles = inst->cycles(true).eft;
+          body << "if (";
+          cGuard(body, inst->guard());
+          body << ")";
+          if (cycles > 0)
+            body << " {\n    fetch += " << cycles << ";";
+          body << "\n    ";
+          genNext(body, i, target);
+          if (cycles > 0)
+            body << "\n  }";
+          body << "\n  else\n    ";
+          genNext(body, i, i + 1);
+        } else if (inst->isUncondBranch() || inst->isFuncCall() ||
+                   inst->isFuncReturn()) {
+          genNext(body, i, target);
+        } else {
+          genNext(body, i, i + 1);
+        }
+        body << '\n';
+      }
+      Buffer_t code;
+      inst->romeoFuncContent(code);
+      body << "  {\n" << code << "  }\n";
+      if (memmem(code.data(), code.size(), "mem", 3) != NULL) {
+        accessesMem = true;
+        body << "  if (mem.fault) {\n    m.address = " << inst->address()
+             << ";\n    m.instructions += " << (i - blocks[b])
+             << ";\n    next = FAULT;\n    goto done;\n  }\n";
+      }
+      if (!inst->isCondBranch() && inst->cycles(false).eft > 0)
+        body << "  fetch += " << inst->cycles(false).eft << ";\n";
+      if ((inst->address() >> 5) == line) {
+        body << "  fetched = fetch + " << timing.iCacheHit << ";\n";
+      } else {
+        body << "  if (cacheAccess(m.ICache, " << inst->address() << "))\n";
+        body << "    fetched = fetch + " << timing.iCacheHit << ";\n";
+        body << "  else {\n    m.iCacheMisses++;\n";
+        body << "    fetched = busFree = max(fetch, busFree) + "
+             << timing.iCacheRefill << ";\n  }\n";
+        line = inst->address() >> 5;
+      }
+      if (inst->memAccessCount() > 0) {
+        body << "  start = max(max(fetched, execFree), busFree);\n";
+        body << "  execFree = busFree = start + "
+             << timing.busAccess * inst->memAccessCount() << ";\n";
+      } else {
+        body << "  start = max(fetched, execFree);\n";
+        body << "  execFree = start + " << timing.exec << ";\n";
+      }
+      body << "  marked = fetch;\n  fetch = start;\n";
+    }
+    out << "static int block" << b << "(machine_t &m) {\n";
+    out << "  core_t core = m.core;\n";
+    if (accessesMem)
+      out << "  mem_t &mem = m.mem;\n";
+    out << "  uint64_t marked = m.marked, fetch = m.fetch;\n";
+    out << "  uint64_t execFree = m.execFree, busFree = m.busFree;\n";
+    out << "  uint64_t fetched, start;\n";
+    out << "  int next;\n";
+    out << body;
+    out << "  m.instructions += " << (blockEnds[b] - blocks[b] + 1) << ";\n";
+    if (accessesMem)
+      out << "done:\n";
+    out << "  m.core = core;\n";
+    out << "  m.marked = marked;\n  m.fetch = fetch;\n";
+    out << "  m.execFree = execFree;\n  m.busFree = busFree;\n";
+    out << "  return next;\n}\n\n";
+  });
+
+  out << "typedef int (*block_t)(machine_t &m);\n";
+  out << "static const block_t blocks[] = {";
+  for (uint32_t b = 0; b < blocks.size(); b++)
+    out << (b % 8 == 0 ? "\n    " : " ") << "block" << b << ',';
+  out << "\n    NULL};\n";
+  out << "static const uint32_t blockAddress[] = {";
+  for (uint32_t b = 0; b < blocks.size(); b++)
+    out << (b % 8 == 0 ? "\n    " : " ") << program[blocks[b]]->address()
+        << ',';
+  out << "\n    0};\n";
+  out << "static const int firstBlock = "
+      << (blocks.empty() ? (count > 0 ? "STOP" : "DEAD_END") : "0") << ";\n";
+  out << "static const uint32_t firstAddress = "
+      << (count > 0 ? program[0]->address() : 0) << ";\n";
+  out << "static const uint64_t maxCycles = " << sim.maxCycles << ";\n";
+  char clock[32];
+  snprintf(clock, sizeof(clock), "%g", sim.clock);
+  out << "static const double clockMHz = " << clock << ";\n\n";
+  out << sTranslationMain;
+
+  out.flush();
+  if (close(fd) != 0) {
+    perror(fileName);
+    exit(1);
+  }
+}
+
+/*
+ * Read a program extracted by extract.awk: the instructions ('t' and 'a'
+ * lines) and the literal words ('w' lines).
+ */
+void readProgram(FILE *file, vector<Inst_t *> &program,
+                 vector<Word_t *> &words) {
+  char *buffer = NULL;
+  size_t bufLen = 0;
+  ssize_t lineLen;
+
+  while ((lineLen = getline(&buffer, &bufLen, file)) != -1) {
+    char delim[] = ":";
+    char *type = strtok(buffer, delim);
+    uint32_t addr = strtol(strtok(NULL, delim), NULL, 16);
+    uint32_t inst = strtol(strtok(NULL, delim), NULL, 16);
+    Inst_t *decodedInst;
+    Word_t *inlineWord;
+    switch (type[0]) {
+    case 't':
+      decodedInst = Inst_t::decodeThumb(addr, inst);
+      if (decodedInst != NULL) {
+        program.push_back(decodedInst);
+        // decodedInst->Print();
+        // if (decodedInst->isLDRPC())
+        //   printf("(%x)", decodedInst->targetWord());
+      }
+      // printf("    %s/%d/%d\n", type, addr, inst);
+      break;
+    case 'w':
+      inlineWord = new Word_t(addr, inst);
+      words.push_back(inlineWord);
+      break;
+    case 'a':
+      decodedInst = Inst_t::decodeARM32(addr, inst);
+      if (decodedInst != NULL) {
+        decodedInst->setWide();
+        program.push_back(decodedInst);
+        // decodedInst->Print();
+      }
+      // printf("    %s/%d/%d\n", type, addr, inst);
+      break;
+    }
+  }
+
+  free(buffer);
+}
+
+/*
+ * Resolve the literals of the LDR PC-relative, number the places and the
+ * transitions from 1 and compute the targets of the branches.
+ */
+void linkProgram(vector<Inst_t *> &program, vector<Word_t *> &words,
+                 vector<uint32_t> &stopAddresses) {
+  for (auto i = program.begin(); i != program.end(); ++i)
+    if ((*i)->isLDRPC()) {
+      for (auto j = words.begin(); j != words.end(); ++j)
+        if ((*i)->targetWord() == (*j)->addr) {
+          (*i)->setImmByPC((*j)->value);
+        }
+    }
+
+  uint32_t placeId = 1;
   uint32_t transitionId = 1;
   for (auto i = program.begin(); i != program.end(); ++i) {
     (*i)->setPlaceId(placeId);
@@ -2273,6 +7851,665 @@ int main(int argc, char *argv[]) {
   }
 
   computeTargetId(program, stopAddresses, 0x8000);
+}
+
+/*
+ * Program of a core given with --core-program instead of the one of the
+ * standard input, with its own stop addresses.
+ */
+struct CoreProgram_t {
+  uint32_t core;
+  vector<Inst_t *> program;
+  vector<Word_t *> words;
+  vector<uint32_t> stopAddresses;
+  string funcPrefix;
+};
+
+/* <core>=<file>,<stop address>[,<stop address>] */
+bool parseCoreProgram(const char *spec, vector<CoreProgram_t *> &programs) {
+  char *end;
+  const uint32_t core = strtoul(spec, &end, 0);
+  if (end == spec || *end != '=' || core == 0)
+    return false;
+  const char *fileName = end + 1;
+  const char *comma = strchr(fileName, ',');
+  if (comma == NULL || comma == fileName)
+    return false;
+  for (auto p = programs.begin(); p != programs.end(); ++p)
+    if ((*p)->core == core)
+      return false;
+  CoreProgram_t *cp = new CoreProgram_t;
+  cp->core = core;
+  cp->funcPrefix = "c" + to_string(core) + "_";
+  while (comma != NULL) {
+    const char *stop = comma + 1;
+    cp->stopAddresses.push_back(strtoul(stop, &end, 0));
+    if (end == stop || (*end != ',' && *end != '\0')) {
+      delete cp;
+      return false;
+    }
+    comma = *end == ',' ? end : NULL;
+  }
+  const string name(fileName, strchr(fileName, ',') - fileName);
+  FILE *file = fopen(name.c_str(), "r");
+  if (file == NULL) {
+    perror(name.c_str());
+    delete cp;
+    return false;
+  }
+  readProgram(file, cp->program, cp->words);
+  fclose(file);
+  programs.push_back(cp);
+  return true;
+}
+
+void usage() {
+  printf("Usage: extract [options] <stop address> [, <stop address>]\n");
+  printf("Options:\n");
+  printf("  --slice-regs      keep in registers_t only the registers the "
+         "program\n"
+         "                    reads and writes\n");
+  printf("  --decl <file>     write the generated declaration sections to "
+         "<file>\n");
+  printf("  --secret <input>  mark a register (r0-r15, sp, lr) or a memory "
+         "range\n"
+         "                    (<address>[:<size>]) as secret and abstract the "
+         "data\n"
+         "                    that depends neither on the secrets nor on the "
+         "branches\n");
+  printf("  -j, --jobs <n>    number of threads used to write the model "
+         "(default:\n"
+         "                    number of cores)\n");
+  printf("  --compact         write the net without layout data nor "
+         "whitespace (the\n"
+         "                    net cannot be edited in the GUI)\n");
+  printf("  --por             give the instruction transitions priority "
+         "over the\n"
+         "                    hardware when the models given with --input "
+         "allow it\n"
+         "                    (partial order reduction)\n");
+  printf("  -o, --output <f>  write the complete Romeo project to <f> "
+         "instead of the\n"
+         "                    net alone to program.xml\n");
+  printf("  --input <file>    model the project is a slave of (can be "
+         "repeated)\n");
+  printf("  --include <file>  file included in the project (can be "
+         "repeated)\n");
+  printf("  --simulate        execute the program on the hardware model and "
+         "print the\n"
+         "                    execution time instead of writing the model\n");
+  printf("  --rodata <file>   with --simulate or --translate, initial memory "
+         "dumped\n"
+         "                    by objdump -s -j .rodata (with --decl, its "
+         "address is\n"
+         "                    dataStart)\n");
+  printf("  --init <x>=<v>    with --simulate, initial value of a register "
+         "(r0-r15, sp,\n"
+         "                    lr) or of the memory word at an address (can "
+         "be repeated)\n");
+  printf("  --cases <file>    with --simulate, one run per line of initial "
+         "values\n");
+  printf("  --sweep <x>=<s>   with --simulate, run every value of the set <s> "
+         "(<v> or\n"
+         "                    <first>..<last>, separated by commas) for the "
+         "register or\n"
+         "                    memory word <x>, and print the distinct "
+         "execution times\n"
+         "                    (can be repeated, all the combinations are "
+         "run)\n");
+  printf("  --check           check that a stop address is reachable from the "
+         "initial\n"
+         "                    states (--init, --sweep) and print the minimum "
+         "and\n"
+         "                    maximum times to reach it\n");
+  printf("  --cores <n>       with --check or the model, number of cores "
+         "sharing the\n"
+         "                    bus (default: 1)\n");
+  printf("  --core-program <k>=<f>,<a>[,<a>] core <k> of the model runs the "
+         "program of\n"
+         "                    <f> up to the stop addresses <a> instead of "
+         "the standard\n"
+         "                    input\n");
+  printf("  --shared <a>:<n>  the <n> bytes of memory from <a> are shared by "
+         "the cores of\n"
+         "                    the model\n");
+  printf("  --static          print static bounds of the execution time "
+         "(implicit\n"
+         "                    path enumeration), the loop bounds being "
+         "those of the runs\n"
+         "                    of the initial states (--init, --sweep) or "
+         "--loop-bound\n");
+  printf("  --loop-bound <a>=<n> with --static, the header of the loop at "
+         "<a> runs at\n"
+         "                    most <n> times per entry in the loop\n");
+  printf("  --zones           print the best and worst case execution times "
+         "with the\n"
+         "                    firing intervals of ICacheHit, T14, T4 and T3 "
+         "read from\n"
+         "                    --input, or the defaults, and --delay (zone "
+         "analysis)\n");
+  printf("  --delay <t>=<i>   with --zones or --replay, firing interval <eft>[,<lft>] of "
+         "the timed\n"
+         "                    transition <t> of hardware.xml (ICacheHit, T14, "
+         "T4, T3)\n");
+  printf("  --deadline <n>    with --zones, print the largest lft of each "
+         "timed\n"
+         "                    transition for which the WCET is at most <n> "
+         "cycles\n");
+  printf("  --trace <file>    with --simulate, write a binary trace of the "
+         "fetches,\n"
+         "                    data accesses and bus accesses of the runs\n");
+  printf("  --replay <file>   print the execution times of the runs of a "
+         "trace with the\n"
+         "                    delays of --delay and the cache of --cache, "
+         "without\n"
+         "                    executing the program (no stop address)\n");
+  printf("  --cache <s>,<w>,<l>[,<p>][,unified] with --decl or --replay, "
+         "cache of <s>\n"
+         "                    sets of <w> lines of <l> bytes, replaced by "
+         "the policy <p>\n"
+         "                    (lru, fifo or plru), accessed by the data "
+         "accesses if\n"
+         "                    unified (default: 16,1,32)\n");
+  printf("  --dcache <s>,<w>,<l>[,<p>] with --decl or --replay, data cache "
+         "of the cores:\n"
+         "                    stores write through it, loads access the "
+         "bus on a miss\n");
+  printf("  --prefetch        fetch whole words through a prefetch buffer, "
+         "for the\n"
+         "                    hardware model twoCoresModel3_prefetch\n");
+  printf("  --mcpu <cpu>      delays of the instruction transitions for the "
+         "cycles of\n"
+         "                    <cpu> beyond the hardware model (cortex-m0, "
+         "cortex-m0plus,\n"
+         "                    cortex-m0plus.small-multiply, cortex-m3 or "
+         "cortex-m4), in\n"
+         "                    the simulation too (the intervals of "
+         "cortex-m3/m4 with\n"
+         "                    --zones and --static only)\n");
+  printf("  --memory-map <f>  with --decl, access count of the instructions "
+         "in bus cycles\n"
+         "                    with the wait states of the regions of <f> "
+         "(T3 of the\n"
+         "                    hardware model set to 1 cycle)\n");
+  printf("  --segments        with --decl, memory of a compact array per "
+         "segment used by\n"
+         "                    the program (.rodata of --rodata, stack and "
+         "the constant\n"
+         "                    addresses accessed)\n");
+  printf("  --segment <name>=<address>:<size> with --decl, segment of the "
+         "memory (implies\n"
+         "                    --segments, can be repeated)\n");
+  printf("  --clock <MHz>     with --simulate or --translate, clock frequency "
+         "(default:\n"
+         "                    48)\n");
+  printf("  --max-cycles <n>  with --simulate or --translate, stop a run after "
+         "<n>\n"
+         "                    cycles (default: 1e9)\n");
+  printf("  --translate <f>   write to <f> a C++ simulator of the program "
+         "instead of the\n"
+         "                    model\n");
+}
+
+int main(int argc, char *argv[]) {
+
+  enum {
+    OPT_SLICE_REGS = 256,
+    OPT_DECL,
+    OPT_SECRET,
+    OPT_COMPACT,
+    OPT_INPUT,
+    OPT_INCLUDE,
+    OPT_SIMULATE,
+    OPT_RODATA,
+    OPT_INIT,
+    OPT_CASES,
+    OPT_CLOCK,
+    OPT_MAX_CYCLES,
+    OPT_TRANSLATE,
+    OPT_SWEEP,
+    OPT_CHECK,
+    OPT_ZONES,
+    OPT_DELAY,
+    OPT_DEADLINE,
+    OPT_POR,
+    OPT_CORES,
+    OPT_STATIC,
+    OPT_LOOP_BOUND,
+    OPT_TRACE,
+    OPT_REPLAY,
+    OPT_CACHE,
+    OPT_CORE_PROGRAM,
+    OPT_SHARED,
+    OPT_DCACHE,
+    OPT_PREFETCH,
+    OPT_SEGMENTS,
+    OPT_SEGMENT,
+    OPT_MCPU,
+    OPT_MEMORY_MAP
+  };
+  static const struct option longOptions[] = {
+      {"slice-regs", no_argument, NULL, OPT_SLICE_REGS},
+      {"decl", required_argument, NULL, OPT_DECL},
+      {"secret", required_argument, NULL, OPT_SECRET},
+      {"jobs", required_argument, NULL, 'j'},
+      {"compact", no_argument, NULL, OPT_COMPACT},
+      {"output", required_argument, NULL, 'o'},
+      {"input", required_argument, NULL, OPT_INPUT},
+      {"include", required_argument, NULL, OPT_INCLUDE},
+      {"simulate", no_argument, NULL, OPT_SIMULATE},
+      {"rodata", required_argument, NULL, OPT_RODATA},
+      {"init", required_argument, NULL, OPT_INIT},
+      {"cases", required_argument, NULL, OPT_CASES},
+      {"clock", required_argument, NULL, OPT_CLOCK},
+      {"max-cycles", required_argument, NULL, OPT_MAX_CYCLES},
+      {"translate", required_argument, NULL, OPT_TRANSLATE},
+      {"sweep", required_argument, NULL, OPT_SWEEP},
+      {"check", no_argument, NULL, OPT_CHECK},
+      {"zones", no_argument, NULL, OPT_ZONES},
+      {"delay", required_argument, NULL, OPT_DELAY},
+      {"deadline", required_argument, NULL, OPT_DEADLINE},
+      {"por", no_argument, NULL, OPT_POR},
+      {"cores", required_argument, NULL, OPT_CORES},
+      {"static", no_argument, NULL, OPT_STATIC},
+      {"loop-bound", required_argument, NULL, OPT_LOOP_BOUND},
+      {"trace", required_argument, NULL, OPT_TRACE},
+      {"replay", required_argument, NULL, OPT_REPLAY},
+      {"cache", required_argument, NULL, OPT_CACHE},
+      {"core-program", required_argument, NULL, OPT_CORE_PROGRAM},
+      {"shared", required_argument, NULL, OPT_SHARED},
+      {"dcache", required_argument, NULL, OPT_DCACHE},
+      {"prefetch", no_argument, NULL, OPT_PREFETCH},
+      {"segments", no_argument, NULL, OPT_SEGMENTS},
+      {"segment", required_argument, NULL, OPT_SEGMENT},
+      {"mcpu", required_argument, NULL, OPT_MCPU},
+      {"memory-map", required_argument, NULL, OPT_MEMORY_MAP},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0}};
+
+  bool sliceRegs = false;
+  const char *declFileName = NULL;
+  bool secrets = false;
+  uint16_t secretRegs = 0;
+  unsigned jobs = thread::hardware_concurrency();
+  bool compact = false;
+  bool por = false;
+  Project_t project;
+  bool simulation = false;
+  Analysis_t analysis = SIMULATE;
+  vector<const char *> delays; // --delay, applied over the ones of --input
+  Simulation_t sim;
+  const char *translationFileName = NULL;
+  const char *replayFileName = NULL;
+  vector<CoreProgram_t *> corePrograms;
+  SharedMemory_t shared;
+  bool prefetch = false;
+  bool segmented = false;
+  vector<Segment_t> segments; // given with --segment
+  const CycleTable_t *cycleTable = NULL;
+  MemoryMap_t memoryMap;
+  bool mapped = false;
+  int opt;
+  while ((opt = getopt_long(argc, argv, "j:o:h", longOptions, NULL)) != -1) {
+    switch (opt) {
+    case OPT_SLICE_REGS:
+      sliceRegs = true;
+      break;
+    case OPT_DECL:
+      declFileName = optarg;
+      break;
+    case OPT_SECRET:
+      if (!parseSecret(optarg, secretRegs)) {
+        fprintf(stderr, "Bad secret input: %s\n", optarg);
+        return 1;
+      }
+      secrets = true;
+      break;
+    case 'j':
+      jobs = strtoul(optarg, NULL, 0);
+      break;
+    case OPT_COMPACT:
+      compact = true;
+      break;
+    case OPT_POR:
+      por = true;
+      break;
+    case 'o':
+      project.output = optarg;
+      break;
+    case OPT_INPUT:
+      project.inputs.push_back(optarg);
+      break;
+    case OPT_INCLUDE:
+      project.includes.push_back(optarg);
+      break;
+    case OPT_SIMULATE:
+      simulation = true;
+      break;
+    case OPT_RODATA:
+      sim.rodata = optarg;
+      break;
+    case OPT_INIT:
+      if (!parseInit(optarg, sim.inits)) {
+        fprintf(stderr, "Bad initial value: %s\n", optarg);
+        return 1;
+      }
+      break;
+    case OPT_CASES:
+      sim.cases = optarg;
+      break;
+    case OPT_CLOCK:
+      sim.clock = strtod(optarg, NULL);
+      break;
+    case OPT_MAX_CYCLES:
+      sim.maxCycles = strtoull(optarg, NULL, 0);
+      break;
+    case OPT_TRANSLATE:
+      translationFileName = optarg;
+      break;
+    case OPT_CHECK:
+      simulation = true;
+      analysis = CHECK;
+      break;
+    case OPT_ZONES:
+      simulation = true;
+      analysis = ZONES;
+      break;
+    case OPT_DELAY:
+      if (!parseDelay(optarg, sim.delays)) {
+        fprintf(stderr, "Bad delay: %s\n", optarg);
+        return 1;
+      }
+      delays.push_back(optarg);
+      break;
+    case OPT_STATIC:
+      simulation = true;
+      analysis = STATIC;
+      break;
+    case OPT_LOOP_BOUND:
+      if (!parseLoopBound(optarg, sim.loopBounds)) {
+        fprintf(stderr, "Bad loop bound: %s\n", optarg);
+        return 1;
+      }
+      break;
+    case OPT_CORES:
+      sim.cores = strtoul(optarg, NULL, 0);
+      if (sim.cores == 0) {
+        fprintf(stderr, "Bad number of cores: %s\n", optarg);
+        return 1;
+      }
+      break;
+    case OPT_DEADLINE:
+      sim.deadline = strtoll(optarg, NULL, 0);
+      break;
+    case OPT_TRACE:
+      sim.trace = optarg;
+      break;
+    case OPT_REPLAY:
+      replayFileName = optarg;
+      break;
+    case OPT_CACHE:
+      if (!parseCacheConfig(optarg, sim.cache)) {
+        fprintf(stderr, "Bad cache: %s\n", optarg);
+        return 1;
+      }
+      break;
+    case OPT_PREFETCH:
+      prefetch = true;
+      break;
+    case OPT_SEGMENT:
+      if (!parseSegment(optarg, segments)) {
+        fprintf(stderr, "Bad segment: %s\n", optarg);
+        return 1;
+      }
+      // fall through
+    case OPT_SEGMENTS:
+      segmented = true;
+      break;
+    case OPT_MEMORY_MAP:
+      if (!readMemoryMap(optarg, memoryMap))
+        return 1;
+      mapped = true;
+      break;
+    case OPT_MCPU:
+      cycleTable = findCycleTable(optarg);
+      if (cycleTable == NULL) {
+        fprintf(stderr, "No cycle table for %s\n", optarg);
+        return 1;
+      }
+      break;
+    case OPT_DCACHE:
+      if (!parseCacheConfig(optarg, sim.dcache) || sim.dcache.unified) {
+        fprintf(stderr, "Bad data cache: %s\n", optarg);
+        return 1;
+      }
+      sim.dataCache = true;
+      break;
+    case OPT_CORE_PROGRAM:
+      if (!parseCoreProgram(optarg, corePrograms)) {
+        fprintf(stderr, "Bad core program: %s\n", optarg);
+        return 1;
+      }
+      break;
+    case OPT_SHARED:
+      if (!parseSharedMemory(optarg, shared)) {
+        fprintf(stderr, "Bad shared memory: %s\n", optarg);
+        return 1;
+      }
+      break;
+    case OPT_SWEEP:
+      if (!parseSweep(optarg, sim.sweeps)) {
+        fprintf(stderr, "Bad sweep: %s\n", optarg);
+        return 1;
+      }
+      break;
+    default:
+      usage();
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  if (replayFileName != NULL)
+    return runReplay(replayFileName, sim);
+
+  if (optind >= argc) {
+    usage();
+    return 1;
+  }
+
+  vector<uint32_t> stopAddresses;
+  for (int i = optind; i < argc; i++) {
+    uint32_t stopAddress = strtol(argv[i], NULL, 0);
+    stopAddresses.push_back(stopAddress);
+  }
+
+  vector<Inst_t *> program;
+  vector<Word_t *> words;
+  readProgram(stdin, program, words);
+  linkProgram(program, words, stopAddresses);
+  for (auto p = corePrograms.begin(); p != corePrograms.end(); ++p)
+    linkProgram((*p)->program, (*p)->words, (*p)->stopAddresses);
+
+  if ((simulation || translationFileName != NULL) &&
+      (!sim.cache.isDefault() || sim.dataCache)) {
+    fprintf(stderr, "--cache and --dcache are taken by --replay and by the "
+                    "model only, the simulation has the cache of the "
+                    "hardware model\n");
+    return 1;
+  }
+  if ((simulation || translationFileName != NULL) && prefetch) {
+    fprintf(stderr, "--prefetch is taken by the model only, the simulation "
+                    "has the fetch of twoCoresModel3_empty\n");
+    return 1;
+  }
+  if ((simulation || translationFileName != NULL) &&
+      (!corePrograms.empty() || shared.size > 0)) {
+    fprintf(stderr, "--core-program and --shared are taken by the model "
+                    "only, the simulation runs the same program on private "
+                    "memories\n");
+    return 1;
+  }
+  if ((simulation || translationFileName != NULL) && cycleTable != NULL &&
+      !cycleTable->exact() && analysis != ZONES && analysis != STATIC) {
+    fprintf(stderr, "The cycles of --mcpu %s are intervals, taken by the "
+                    "model, --zones and --static only\n",
+            cycleTable->cpu);
+    return 1;
+  }
+  if (sim.trace != NULL && cycleTable != NULL) {
+    fprintf(stderr, "The trace of --trace has no cycles of --mcpu, the "
+                    "replay has the timing of the hardware model\n");
+    return 1;
+  }
+  if ((simulation || translationFileName != NULL) && mapped) {
+    fprintf(stderr, "--memory-map is taken by the model only, the simulation "
+                    "has the bus access of the hardware model\n");
+    return 1;
+  }
+  if ((simulation || translationFileName != NULL) && segmented) {
+    fprintf(stderr, "--segments is taken by the model only, the simulation "
+                    "has the flat memory\n");
+    return 1;
+  }
+  if (analysis == ZONES && !project.inputs.empty()) {
+    // the intervals of the hardware model, --delay overriding them
+    if (!readDelays(project.inputs, sim.delays))
+      return 1;
+    for (auto d = delays.begin(); d != delays.end(); ++d)
+      parseDelay(*d, sim.delays);
+  }
+  Inst_t::setCycleTable(cycleTable);
+  if (simulation)
+    return runSimulation(program, stopAddresses, sim, jobs, analysis);
+  if (translationFileName != NULL) {
+    generateTranslation(program, stopAddresses, sim, translationFileName,
+                        jobs);
+    return 0;
+  }
+
+  if ((!sim.cache.isDefault() || sim.dataCache) && declFileName == NULL) {
+    fprintf(stderr, "--cache and --dcache need --decl to generate the "
+                    "cache\n");
+    return 1;
+  }
+  if (mapped && declFileName == NULL) {
+    fprintf(stderr, "--memory-map needs --decl to generate memCycles()\n");
+    return 1;
+  }
+  if (mapped && sim.rodata == NULL) {
+    fprintf(stderr, "--memory-map needs --rodata to place the stack after "
+                    ".rodata\n");
+    return 1;
+  }
+  if (mapped && (sim.cache.unified || sim.dataCache)) {
+    fprintf(stderr, "With a unified or data cache, the bus accesses are "
+                    "counted by the cache, no --memory-map\n");
+    return 1;
+  }
+  if (mapped && secrets) {
+    fprintf(stderr, "The data abstraction of --secret removes the data "
+                    "accesses counted with --memory-map\n");
+    return 1;
+  }
+  if (segmented && declFileName == NULL) {
+    fprintf(stderr, "--segments needs --decl to generate the memory\n");
+    return 1;
+  }
+  if (shared.size > 0 && declFileName != NULL && sim.rodata == NULL) {
+    fprintf(stderr, "--shared needs --rodata to initialize the constants "
+                    "of the shared memory\n");
+    return 1;
+  }
+  if (segmented && shared.size > 0) {
+    fprintf(stderr, "The shared memory of --shared is not a segment of "
+                    "--segments\n");
+    return 1;
+  }
+  if (sim.cache.unified && sim.dataCache) {
+    fprintf(stderr, "A unified cache already takes the data accesses, no "
+                    "--dcache\n");
+    return 1;
+  }
+  for (auto p = corePrograms.begin(); p != corePrograms.end(); ++p)
+    if ((*p)->core >= sim.cores) {
+      fprintf(stderr, "No core %u among the %u cores of --cores\n",
+              (*p)->core, sim.cores);
+      return 1;
+    }
+  if (secrets && (!corePrograms.empty() || shared.size > 0)) {
+    fprintf(stderr, "The data abstraction of --secret is done on a single "
+                    "program with a private memory\n");
+    return 1;
+  }
+  if (secrets && (sim.cache.unified || sim.dataCache)) {
+    fprintf(stderr, "The data abstraction of --secret keeps the data "
+                    "accesses out of the caches (no unified or data "
+                    "cache)\n");
+    return 1;
+  }
+  Inst_t::setUnifiedCache(sim.cache.unified);
+  Inst_t::setDataCache(sim.dataCache);
+  Inst_t::setPrefetch(prefetch);
+  Inst_t::setSharedMem(shared.size > 0);
+  Inst_t::setMemoryMap(mapped);
+  vector<vector<Inst_t *> *> programs(1, &program);
+  for (auto p = corePrograms.begin(); p != corePrograms.end(); ++p) {
+    programs.push_back(&(*p)->program);
+    for (auto i = (*p)->program.begin(); i != (*p)->program.end(); ++i)
+      (*i)->setFuncPrefix((*p)->funcPrefix.c_str());
+  }
+  if (secrets)
+    abstractData(program, secretRegs);
+  if (sliceRegs)
+    sliceRegisters(programs);
+  if (declFileName != NULL) {
+    uint32_t dataStart = Machine_t::sDefaultDataStart;
+    vector<pair<uint32_t, uint32_t>> consts;
+    if (sim.rodata != NULL && !readRodata(sim.rodata, dataStart, consts))
+      return 1;
+    if (segmented)
+      segments = computeSegments(programs, dataStart, consts.size(), segments);
+    if (mapped)
+      classifyAccesses(programs, memoryMap, dataStart, consts.size());
+    generateDeclarations(declFileName, program, sim.cache,
+                         sim.dataCache ? &sim.dcache : NULL, dataStart,
+                         sim.cores, shared, prefetch, segments, consts,
+                         mapped ? &memoryMap : NULL);
+  }
+  for (auto p = programs.begin(); p != programs.end(); ++p)
+    genFuncs(**p, jobs);
+
+  /*
+   * The cores running the program of the standard input share its net, the
+   * core being the color of the token. With programs of their own, each core
+   * has its own copy of the net of its program, the core of its guards and
+   * updates is fixed and its places and transitions are prefixed by the
+   * core, but the ones of core 0.
+   */
+  vector<CoreNet_t> nets;
+  uint32_t placeOffset = 0;
+  uint32_t transitionOffset = 0;
+  for (uint32_t core = 0; core < (corePrograms.empty() ? 1 : sim.cores);
+       core++) {
+    CoreNet_t net = {&program, &words, &stopAddresses, "$any", "",
+                     placeOffset, transitionOffset};
+    for (auto p = corePrograms.begin(); p != corePrograms.end(); ++p)
+      if ((*p)->core == core) {
+        net.program = &(*p)->program;
+        net.words = &(*p)->words;
+        net.stopAddresses = &(*p)->stopAddresses;
+      }
+    if (!corePrograms.empty()) {
+      net.index = to_string(core);
+      if (core > 0)
+        net.prefix = "C" + to_string(core) + "_";
+    }
+    Inst_t *last = net.program->back();
+    placeOffset += last->placeId();
+    transitionOffset += last->isCondBranch() ? last->transitionIdTaken()
+                                             : last->transitionId();
+    nets.push_back(net);
+  }
 
   // for (auto i = program.begin(); i != program.end(); ++i) {
   //   if ((*i)->isReachable()) {
@@ -2283,7 +8520,9 @@ int main(int argc, char *argv[]) {
   //     printf("\n");
   //   }
   // }
-  generatePN(program, words, stopAddresses);
+  const uint32_t priority =
+      por && checkInstructionPriority(project.inputs) ? 1 : 0;
+  generatePN(nets, sim.cores, jobs, compact, project, priority);
 
   return 0;
 }
@@ -1,9 +1,15 @@
 import argparse
+import json
 import os.path
 import re
+import tempfile
 
 output_dir = "generated_files/"
 
+# format of the templates, in their name so that a template written by an
+# older parse_template is not read again
+template_version = 1
+
 def transform_number(entry):
     """
     From a number of rodata line, get an integer
@@ -76,38 +82,134 @@ def parse_rodata(file_content):
     return ret_table
 
 
-def write_in_file(ufile, memory_entries, output_name):
+def parse_sections(file_content):
+    """
+    Parse the declaration sections generated by extract
+    :param file_content: Content of a sections file (list of lines)
+    :return: Dictionary {section name: list of lines}
+    """
+    sections = {}
+    name = None
+    r = re.compile(r"^// @section (\w+)")
+    for line in file_content:
+        m = r.match(line)
+        if m:
+            name = m.groups()[0]
+            sections[name] = []
+        elif name is not None:
+            sections[name].append(line)
+    return sections
+
+
+def parse_template(content):
+    """
+    Pre-parse a declaration file into a template, where only the program
+    specific parts remain to be written
+    :param content: Content of a declaration file (list of lines)
+    :return: List of parts: ["text", text], ["region", name, lines of the region],
+    ["dataStart"] or ["initConsts"]
+    """
+    parts = []
+    text = []
+    region = None
+    begin = re.compile(r"^// @begin (\w+)")
+    end = re.compile(r"^// @end (\w+)")
+
+    def flush_text():
+        if text:
+            parts.append(["text", "".join(text)])
+            del text[:]
+
+    for line in content:
+        m = begin.match(line)
+        if m:
+            flush_text()
+            region = ["region", m.groups()[0], []]
+            parts.append(region)
+        elif end.match(line):
+            region = None
+        elif region is not None:
+            region[2].append(line)
+        elif "const int dataStart" in line:
+            flush_text()
+            parts.append(["dataStart"])
+        elif "void initConsts" in line:
+            flush_text()
+            parts.append(["initConsts"])
+        else:
+            text.append(line)
+    flush_text()
+    return parts
+
+
+def load_template(ufile):
+    """
+    Template of a declaration file, kept in the output directory as
+    [model]_[declaration file].v[version].template and parsed again only when
+    the declaration file is newer. The template is written to a temporary
+    file renamed in place, so that a concurrent run never reads it half
+    written
+    :param ufile: declaration file of a hardware model
+    :return: Template (see parse_template)
+    """
+    path = os.path.abspath(ufile)
+    template_name = "{}_{}.v{}.template".format(os.path.basename(os.path.dirname(path)), get_filename(ufile),
+                                                template_version)
+    template_path = os.path.join(output_dir, template_name)
+    if os.path.isfile(template_path) and os.path.getmtime(template_path) >= os.path.getmtime(ufile):
+        with open(template_path, "r") as f:
+            return json.load(f)
+    with open(ufile, "r") as f:
+        template = parse_template(f.readlines())
+    if os.path.isdir(output_dir):
+        fd, temp_path = tempfile.mkstemp(dir=output_dir, suffix=".tmp")
+        with os.fdopen(fd, "w") as f:
+            json.dump(template, f)
+        os.replace(temp_path, template_path)
+    return template
+
+
+def write_in_file(ufile, memory_entries, output_name, sections={}):
     """
     Update the declaration file with the content of the memory
     :param file: input declaration file
     :param memory_entries: table of memory entries or None if no table of memory entries
     :param output_name: Name of the output file
+    :param sections: generated sections replacing the "// @begin [name]" ... "// @end [name]" regions
     :return: None (write a file, [output_dir]/[declaration file]_[model].c)
     """
     try:
-        input = open(ufile, "r")
-        content = input.readlines()
+        template = load_template(ufile)
         new_content = []
 
-        for line in content:
-            # Update datastart
-            if "const int dataStart" in line:
-                #if memory_entries == None:
-                    #raise Exception("Impossible case: const int dataStart found, but no memory_entries found!")
+        for part in template:
+            if part[0] == "text":
+                new_content.append(part[1])
+            elif part[0] == "region":
+                # Region replaced by a generated section
+                new_content.extend(sections.get(part[1], part[2]))
+            elif part[0] == "dataStart":
+                # Update datastart
                 if memory_entries != None:
                     datastart = memory_entries[0][0]
                 else:
                     datastart = 0
                 new_content.append("const int dataStart = {};\n".format(datastart))
-            elif "void initConsts" in line:
+            elif "initConsts" in sections:
+                # Memory written by the generated section (segmented memory)
+                new_content.extend(sections["initConsts"])
+            else:
                 # Write function update memory
                 new_content.append("void initConsts(mem_t &mem) {\n")
                 if memory_entries != None:
                     for k in memory_entries:
-                        new_content.append("\tmemWrite(mem, {},{});\n".format(k[0], k[1]))
+                        if "memAccess" in sections:
+                            # The generated memory accesses also take the shared memory,
+                            # the constants are in the memory of the core
+                            new_content.append("\tmem.a[({} - dataStart) / 4] = {};\n".format(k[0], k[1]))
+                        else:
+                            new_content.append("\tmemWrite(mem, {},{});\n".format(k[0], k[1]))
                 new_content.append("}\n")
-            else:
-                new_content.append(line)
 
         # Write file
         output_path = os.path.join(output_dir, output_name)
@@ -137,6 +239,9 @@ if __name__ == "__main__":
     parser.add_argument('-ufile',
                         default="declarations.c",
                         help="if -u is set, set the input declaration file (default: declarations.c)'")
+    parser.add_argument('-splice',
+                        action='append', default=[],
+                        help="if -u is set, file of sections generated by extract --decl (or arbiter.py) to splice in the declaration file (can be repeated)")
     args = parser.parse_args()
 
     # Parsing function
@@ -153,8 +258,13 @@ if __name__ == "__main__":
             print("memWrite(mem, {},{});".format(k[0], k[1]))
 
     if args.u:
+        sections = {}
+        for splice in args.splice:
+            file = open(splice, "r")
+            sections.update(parse_sections(file.readlines()))
+            file.close()
         output_name = "{}_{}.c".format(get_filename(args.ufile), get_filename(args.file))
         if memory_entries != []:
-            write_in_file(args.ufile, memory_entries, output_name)
+            write_in_file(args.ufile, memory_entries, output_name, sections)
         else:
-            write_in_file(args.ufile, None, output_name)
+            write_in_file(args.ufile, None, output_name, sections)